@@ -0,0 +1,89 @@
+// Compares the old per-call std::mt19937 + distribution path against Rng
+// for the draw patterns the overlay uses.
+#include "rng.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static volatile float g_sinkF;
+static volatile uint64_t g_sinkU;
+
+template <typename Fn>
+static double BestNsPerItem(size_t items, Fn&& fn) {
+    double best = 1e30;
+    for (int rep = 0; rep < 7; ++rep) {
+        auto t0 = Clock::now();
+        fn();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        if (ns < best) best = ns;
+    }
+    return best / static_cast<double>(items);
+}
+
+static float RandFloat(std::mt19937& rng, float lo, float hi) {
+    std::uniform_real_distribution<float> dist(lo, hi);
+    return dist(rng);
+}
+
+static int RandInt(std::mt19937& rng, int lo, int hi) {
+    std::uniform_int_distribution<int> dist(lo, hi);
+    return dist(rng);
+}
+
+static void Report(const char* name, double before, double after) {
+    std::printf("%-28s mt19937 %7.2f ns   Rng %7.2f ns   %5.1fx\n", name, before, after, before / after);
+}
+
+int main() {
+    const size_t n = 1 << 20;
+    std::vector<float> out(n);
+    std::mt19937 mt(1234);
+    Rng rng(1234);
+
+    double before = BestNsPerItem(n, [&] {
+        for (size_t i = 0; i < n; ++i) out[i] = RandFloat(mt, -1.4f, 1.4f);
+        g_sinkF = out[n / 2];
+    });
+    double after = BestNsPerItem(n, [&] {
+        for (size_t i = 0; i < n; ++i) out[i] = rng.Float(-1.4f, 1.4f);
+        g_sinkF = out[n / 2];
+    });
+    Report("float per call", before, after);
+
+    after = BestNsPerItem(n, [&] {
+        rng.FillFloats(out.data(), n, -1.4f, 1.4f);
+        g_sinkF = out[n / 2];
+    });
+    Report("float bulk fill", before, after);
+
+    before = BestNsPerItem(n, [&] {
+        int sum = 0;
+        for (size_t i = 0; i < n; ++i) sum += RandInt(mt, -22, 26);
+        g_sinkU = static_cast<uint64_t>(sum);
+    });
+    after = BestNsPerItem(n, [&] {
+        int sum = 0;
+        for (size_t i = 0; i < n; ++i) sum += rng.Int(-22, 26);
+        g_sinkU = static_cast<uint64_t>(sum);
+    });
+    Report("int per call", before, after);
+
+    // Blink update: one 1-in-3 decision per ornament.
+    before = BestNsPerItem(n, [&] {
+        uint64_t flips = 0;
+        for (size_t i = 0; i < n; ++i) flips += RandInt(mt, 0, 2) == 0;
+        g_sinkU = flips;
+    });
+    after = BestNsPerItem(n, [&] {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < n; i += 64) mask ^= rng.BernoulliMask(1.0 / 3.0);
+        g_sinkU = mask;
+    });
+    Report("blink decision (1/3)", before, after);
+    return 0;
+}
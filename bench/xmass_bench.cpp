@@ -0,0 +1,305 @@
+// Scene benchmarks for tracking regressions: scene generation across window
+// sizes, loading a saved scene, live-resize steps, the animation tick and
+// snapshot handoff across snow budgets, and full offscreen frames, all from
+// a fixed seed. Prints one JSON document with the median and p99 time and
+// the heap allocations per iteration of each case.
+//
+//   xmass_bench [--filter=SUBSTR] [--iterations=N] [--threads=N] [--out=FILE]
+#include "headless_context.h"
+#include "scene.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr uint64_t kSeed = 1234;
+
+struct BenchOptions {
+    const char* filter = nullptr;
+    int iterations = 0; // 0 keeps each case's default
+    int threads = 0;
+    const char* outPath = nullptr;
+};
+
+struct BenchResult {
+    std::string name;
+    int iterations = 0;
+    double medianUs = 0.0;
+    double p99Us = 0.0;
+    double allocsPerIter = 0.0;
+    size_t sceneBytes = 0; // SceneMemoryBytes() afterwards, for scene generation
+};
+
+static BenchOptions g_bench{};
+static std::vector<BenchResult> g_results;
+
+static double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+static bool Selected(const std::string& name) {
+    return !g_bench.filter || name.find(g_bench.filter) != std::string::npos;
+}
+
+// Times `iterations` calls of fn one by one after a short warm-up. Setup
+// that should not count belongs in `prepare`, which runs untimed before
+// every call.
+template <typename Prepare, typename Fn>
+static void Run(const std::string& name, int iterations, Prepare&& prepare, Fn&& fn) {
+    if (g_bench.iterations > 0) iterations = g_bench.iterations;
+    for (int i = 0; i < 3; ++i) {
+        prepare();
+        fn();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(iterations));
+    uint64_t allocations = 0;
+    for (int i = 0; i < iterations; ++i) {
+        prepare();
+        uint64_t before = g_allocations.load(std::memory_order_relaxed);
+        Clock::time_point t0 = Clock::now();
+        fn();
+        Clock::time_point t1 = Clock::now();
+        allocations += g_allocations.load(std::memory_order_relaxed) - before;
+        samples.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+    }
+
+    BenchResult r;
+    r.name = name;
+    r.iterations = iterations;
+    r.medianUs = Percentile(samples, 0.5);
+    r.p99Us = Percentile(samples, 0.99);
+    r.allocsPerIter = static_cast<double>(allocations) / iterations;
+    std::fprintf(stderr, "%-36s median %10.1f us  p99 %10.1f us  allocs %8.1f\n", name.c_str(), r.medianUs, r.p99Us, r.allocsPerIter);
+    g_results.push_back(r);
+}
+
+static void ResetScene(int w, int h, int snowBudget) {
+    g_sceneOptions.snowBudget = snowBudget;
+    g_state.rng.Seed(kSeed);
+    RegenerateScene(w, h);
+    PublishSnapshot(0.0);
+    AcquireSnapshot();
+}
+
+// Attaches the footprint of the scene just generated, published once so
+// the geometry copy counts too, to the last result.
+static void RecordSceneBytes() {
+    PublishSnapshot(0.0);
+    AcquireSnapshot();
+    g_results.back().sceneBytes = SceneMemoryBytes();
+}
+
+static void BenchRegenerate() {
+    const int sizes[][2] = {{200, 200}, {800, 600}, {1280, 720}, {1920, 1080}, {2560, 1440}, {3840, 2160}};
+    for (const auto& size : sizes) {
+        std::string name = "RegenerateScene/" + std::to_string(size[0]) + "x" + std::to_string(size[1]);
+        if (!Selected(name)) continue;
+        Run(name, 200, [&] { g_state.rng.Seed(kSeed); }, [&] { RegenerateScene(size[0], size[1]); });
+        RecordSceneBytes();
+    }
+
+    const std::string name = "RegenerateScene/3840x2160/100000-needles";
+    if (Selected(name)) {
+        g_sceneOptions.needleBudget = 100000;
+        Run(name, 50, [&] { g_state.rng.Seed(kSeed); }, [&] { RegenerateScene(3840, 2160); });
+        RecordSceneBytes();
+        g_sceneOptions.needleBudget = 0;
+    }
+
+    // The same scene started from a file instead: map, check, one copy per
+    // array. The file is written once to the working directory.
+    const std::string load = "LoadScene/3840x2160/100000-needles";
+    if (Selected(load)) {
+        static const char* kScenePath = "xmass_bench.scene";
+        g_sceneOptions.needleBudget = 100000;
+        ResetScene(3840, 2160, 0);
+        if (SaveScene(kScenePath)) {
+            Run(load, 50, [] {}, [] { LoadScene(kScenePath); });
+            std::remove(kScenePath);
+        }
+        g_sceneOptions.needleBudget = 0;
+    }
+
+    // One coalesced live-resize step: rescale plus top-up/trim, against
+    // the full regeneration it replaces.
+    const int steps[][4] = {{1280, 720, 1300, 740}, {1920, 1080, 1280, 720}};
+    for (const auto& s : steps) {
+        std::string resize = "ResizeScene/" + std::to_string(s[0]) + "x" + std::to_string(s[1]) + "-" + std::to_string(s[2]) + "x" + std::to_string(s[3]);
+        if (!Selected(resize)) continue;
+        Run(resize, 200, [&] { ResetScene(s[0], s[1], 0); }, [&] { ResizeScene(s[2], s[3]); });
+    }
+}
+
+static void BenchAnimation() {
+    const int budgets[] = {220, 10000, 100000, 1000000};
+    // As on the simulation thread: each tick steps from the last published
+    // snapshot into the next slot.
+    for (int budget : budgets) {
+        std::string name = "UpdateAnimationStep/" + std::to_string(budget);
+        if (!Selected(name)) continue;
+        ResetScene(1920, 1080, budget);
+        Run(
+            name, 300,
+            [] {
+                PublishSnapshot(0.0);
+                AcquireSnapshot();
+            },
+            [] { UpdateAnimationStep(); });
+    }
+
+    // The simulation thread's per-tick handoff to the renderer. The tick
+    // has already written the slot, so this is the index flip plus the
+    // geometry check.
+    for (int budget : budgets) {
+        std::string name = "PublishSnapshot/" + std::to_string(budget);
+        if (!Selected(name)) continue;
+        ResetScene(1920, 1080, budget);
+        Run(
+            name, 300,
+            [] {
+                UpdateAnimationStep();
+                AcquireSnapshot();
+            },
+            [] { PublishSnapshot(0.0); });
+    }
+}
+
+// One RenderFrame of the same scene per iteration, including glFinish so
+// the GPU (or llvmpipe) work is counted. The tree cache is built during
+// warm-up, as it is after the first frame in the app.
+static void BenchFrames(int w, int h) {
+    const std::string suffix = "/" + std::to_string(w) + "x" + std::to_string(h);
+    // Core with MSAA, core with the single-sampled SDF shapes, legacy.
+    const struct {
+        const char* label;
+        bool core;
+        bool sdf;
+    } modes[] = {{"core", true, false}, {"core-sdf", true, true}, {"legacy", false, false}};
+    for (const auto& mode : modes) {
+        const bool core = mode.core;
+        std::string name = std::string("Frame/") + mode.label + suffix;
+        if (!Selected(name)) continue;
+
+        g_sceneOptions.sdfAntialias = mode.sdf;
+        HeadlessContext context;
+        if (!context.Create(w, h, core, mode.sdf ? 0 : 4) || !InitRenderer(HeadlessContext::Loader(), core)) {
+            std::fprintf(stderr, "%s: no offscreen %s context, skipped\n", name.c_str(), core ? "core" : "legacy");
+            context.Destroy();
+            g_sceneOptions.sdfAntialias = false;
+            continue;
+        }
+        ResetScene(w, h, 0);
+        Run(name, 100, [] {}, [&] {
+            RenderFrame(w, h, 1.0f);
+            glFinish();
+        });
+        ShutdownRenderer();
+        context.Destroy();
+        g_sceneOptions.sdfAntialias = false;
+    }
+
+    std::string name = "Frame/software" + suffix;
+    if (Selected(name)) {
+        ResetScene(w, h, 0);
+        Run(name, 100, [] {}, [&] { RenderFrameSoftware(w, h, 1.0f); });
+    }
+}
+
+static void WriteJson(std::FILE* out) {
+    std::fprintf(out, "{\n  \"seed\": %llu,\n  \"snow_kernel\": \"%s\",\n  \"workers\": %d,\n  \"benchmarks\": [\n",
+                 static_cast<unsigned long long>(kSeed), SnowKernelName(), g_pool.WorkerCount());
+    for (size_t i = 0; i < g_results.size(); ++i) {
+        const BenchResult& r = g_results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"iterations\": %d, \"median_us\": %.3f, \"p99_us\": %.3f, \"allocs_per_iter\": %.2f",
+                     r.name.c_str(), r.iterations, r.medianUs, r.p99Us, r.allocsPerIter);
+        if (r.sceneBytes) std::fprintf(out, ", \"scene_bytes\": %zu", r.sceneBytes);
+        std::fprintf(out, "}%s\n", i + 1 < g_results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--filter=", 9) == 0) {
+            g_bench.filter = arg + 9;
+        } else if (std::strncmp(arg, "--iterations=", 13) == 0) {
+            g_bench.iterations = std::max(1, std::atoi(arg + 13));
+        } else if (std::strncmp(arg, "--threads=", 10) == 0) {
+            g_bench.threads = std::max(0, std::atoi(arg + 10));
+        } else if (std::strncmp(arg, "--out=", 6) == 0) {
+            g_bench.outPath = arg + 6;
+        } else {
+            std::fprintf(stderr, "usage: xmass_bench [--filter=SUBSTR] [--iterations=N] [--threads=N] [--out=FILE]\n");
+            return 2;
+        }
+    }
+
+    g_pool.Start(g_bench.threads);
+    g_simPool.Start(g_bench.threads);
+    BenchRegenerate();
+    BenchAnimation();
+    BenchFrames(1280, 720);
+    g_pool.Stop();
+    g_simPool.Stop();
+
+    std::FILE* out = stdout;
+    if (g_bench.outPath && !(out = std::fopen(g_bench.outPath, "w"))) {
+        std::fprintf(stderr, "xmass_bench: cannot write %s\n", g_bench.outPath);
+        return 1;
+    }
+    WriteJson(out);
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
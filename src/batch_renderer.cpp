@@ -0,0 +1,261 @@
+#include "batch_renderer.h"
+
+#include "soft_rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const char* kBatchVertexShader = R"(#version 330 core
+uniform vec2 uViewport;
+in vec2 aPos;
+in vec4 aColor;
+out vec4 vColor;
+void main() {
+    vec2 ndc = aPos / uViewport * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    vColor = aColor;
+}
+)";
+
+static const char* kBatchFragmentShader = R"(#version 330 core
+in vec4 vColor;
+out vec4 fragColor;
+void main() {
+    fragColor = vColor;
+}
+)";
+
+bool BatchRenderer::InitCore() {
+    const char* attributes[] = {"aPos", "aColor"};
+    program_ = BuildProgram(kBatchVertexShader, kBatchFragmentShader, attributes, 2);
+    if (!program_) {
+        return false;
+    }
+    viewportLoc_ = g_gl.GetUniformLocation(program_, "uViewport");
+
+    g_gl.GenVertexArrays(1, &vao_);
+    g_gl.GenBuffers(1, &vbo_);
+    g_gl.GenBuffers(1, &ebo_);
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, vbo_);
+    g_gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    g_gl.EnableVertexAttribArray(0);
+    g_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), reinterpret_cast<const void*>(offsetof(BatchVertex, x)));
+    g_gl.EnableVertexAttribArray(1);
+    g_gl.VertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BatchVertex), reinterpret_cast<const void*>(offsetof(BatchVertex, r)));
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void BatchRenderer::DestroyCore() {
+    if (ebo_) g_gl.DeleteBuffers(1, &ebo_);
+    if (vbo_) g_gl.DeleteBuffers(1, &vbo_);
+    if (vao_) g_gl.DeleteVertexArrays(1, &vao_);
+    if (program_) g_gl.DeleteProgram(program_);
+    ebo_ = 0;
+    vbo_ = 0;
+    vao_ = 0;
+    program_ = 0;
+}
+
+void BatchRenderer::Begin() {
+    vertices_.clear();
+    indices_.clear();
+    batches_.clear();
+    blend_ = BlendMode::Alpha;
+    lineWidth_ = 1.0f;
+}
+
+BatchRenderer::Batch& BatchRenderer::Current(GLenum mode) {
+    if (!batches_.empty()) {
+        Batch& last = batches_.back();
+        bool sameWidth = mode != GL_LINES || last.lineWidth == lineWidth_;
+        if (last.mode == mode && last.blend == blend_ && sameWidth) {
+            return last;
+        }
+    }
+
+    Batch b;
+    b.mode = mode;
+    b.blend = blend_;
+    b.lineWidth = lineWidth_;
+    b.first = indices_.size();
+    batches_.push_back(b);
+    return batches_.back();
+}
+
+uint32_t BatchRenderer::Vertex(float x, float y, const Color& c) {
+    BatchVertex v;
+    v.x = x;
+    v.y = y;
+    v.r = ToByte(c.r);
+    v.g = ToByte(c.g);
+    v.b = ToByte(c.b);
+    v.a = ToByte(c.a);
+    vertices_.push_back(v);
+    return static_cast<uint32_t>(vertices_.size() - 1);
+}
+
+void BatchRenderer::TriangleIndices(uint32_t a, uint32_t b, uint32_t c) {
+    Current(GL_TRIANGLES).count += 3;
+    indices_.push_back(a);
+    indices_.push_back(b);
+    indices_.push_back(c);
+}
+
+void BatchRenderer::LineIndices(uint32_t a, uint32_t b) {
+    if (program_) {
+        LineQuad(a, b);
+        return;
+    }
+    Current(GL_LINES).count += 2;
+    indices_.push_back(a);
+    indices_.push_back(b);
+}
+
+void BatchRenderer::LineQuad(uint32_t a, uint32_t b) {
+    const BatchVertex va = vertices_[a];
+    const BatchVertex vb = vertices_[b];
+    float dx = vb.x - va.x;
+    float dy = vb.y - va.y;
+    float len = std::sqrt(dx * dx + dy * dy);
+    if (len <= 0.0f) return;
+
+    float scale = lineWidth_ * 0.5f / len;
+    float nx = -dy * scale;
+    float ny = dx * scale;
+
+    BatchVertex quad[4] = {va, va, vb, vb};
+    quad[0].x += nx;
+    quad[0].y += ny;
+    quad[1].x -= nx;
+    quad[1].y -= ny;
+    quad[2].x -= nx;
+    quad[2].y -= ny;
+    quad[3].x += nx;
+    quad[3].y += ny;
+
+    uint32_t base = static_cast<uint32_t>(vertices_.size());
+    vertices_.insert(vertices_.end(), quad, quad + 4);
+    TriangleIndices(base, base + 1, base + 2);
+    TriangleIndices(base, base + 2, base + 3);
+}
+
+void BatchRenderer::Triangle(float x0, float y0, float x1, float y1, float x2, float y2, const Color& c) {
+    Triangle(x0, y0, c, x1, y1, c, x2, y2, c);
+}
+
+void BatchRenderer::Triangle(float x0, float y0, const Color& c0, float x1, float y1, const Color& c1, float x2, float y2, const Color& c2) {
+    uint32_t a = Vertex(x0, y0, c0);
+    uint32_t b = Vertex(x1, y1, c1);
+    uint32_t c = Vertex(x2, y2, c2);
+    TriangleIndices(a, b, c);
+}
+
+void BatchRenderer::Line(float x0, float y0, float x1, float y1, const Color& c) {
+    uint32_t a = Vertex(x0, y0, c);
+    uint32_t b = Vertex(x1, y1, c);
+    LineIndices(a, b);
+}
+
+void BatchRenderer::SetBlendState(BlendMode mode) const {
+    if (mode == BlendMode::Premultiplied) {
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else if (premultipliedTarget_ && g_gl.BlendFuncSeparate) {
+        g_gl.BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+}
+
+void BatchRenderer::Flush() {
+    drawCallsLastFlush_ = 0;
+    if (!batches_.empty()) {
+        if (software_) {
+            FlushSoftware();
+        } else if (program_) {
+            FlushCore();
+        } else {
+            FlushLegacy();
+        }
+    }
+
+    vertices_.clear();
+    indices_.clear();
+    batches_.clear();
+}
+
+void BatchRenderer::FlushSoftware() {
+    for (const Batch& b : batches_) {
+        const bool premultiplied = b.blend == BlendMode::Premultiplied;
+        const uint32_t* idx = indices_.data() + b.first;
+        if (b.mode == GL_LINES) {
+            for (size_t i = 0; i + 1 < b.count; i += 2) {
+                software_->Line(vertices_[idx[i]], vertices_[idx[i + 1]], b.lineWidth, premultiplied);
+            }
+        } else {
+            for (size_t i = 0; i + 2 < b.count; i += 3) {
+                software_->Triangle(vertices_[idx[i]], vertices_[idx[i + 1]], vertices_[idx[i + 2]], premultiplied);
+            }
+        }
+    }
+}
+
+void BatchRenderer::FlushLegacy() {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), &vertices_[0].x);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), &vertices_[0].r);
+
+    bool first = true;
+    BlendMode blend = BlendMode::Alpha;
+    float lineWidth = 0.0f;
+    for (const Batch& b : batches_) {
+        if (b.count == 0) continue;
+        if (first || b.blend != blend) {
+            blend = b.blend;
+            SetBlendState(blend);
+        }
+        if (b.mode == GL_LINES && b.lineWidth != lineWidth) {
+            lineWidth = b.lineWidth;
+            glLineWidth(lineWidth);
+        }
+        first = false;
+        glDrawElements(b.mode, static_cast<GLsizei>(b.count), GL_UNSIGNED_INT, &indices_[b.first]);
+        ++drawCallsLastFlush_;
+    }
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void BatchRenderer::FlushCore() {
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    g_gl.UseProgram(program_);
+    g_gl.Uniform2f(viewportLoc_, static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, vbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(vertices_.size() * sizeof(BatchVertex)), vertices_.data(), GL_STREAM_DRAW);
+    g_gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(indices_.size() * sizeof(uint32_t)), indices_.data(), GL_STREAM_DRAW);
+
+    bool first = true;
+    BlendMode blend = BlendMode::Alpha;
+    for (const Batch& b : batches_) {
+        if (b.count == 0) continue;
+        if (first || b.blend != blend) {
+            blend = b.blend;
+            SetBlendState(blend);
+        }
+        first = false;
+        const void* offset = reinterpret_cast<const void*>(b.first * sizeof(uint32_t));
+        glDrawElements(b.mode, static_cast<GLsizei>(b.count), GL_UNSIGNED_INT, offset);
+        ++drawCallsLastFlush_;
+    }
+
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    g_gl.UseProgram(0);
+}
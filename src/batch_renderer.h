@@ -0,0 +1,95 @@
+#pragma once
+
+#include "color.h"
+#include "gl_ext.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SoftRasterizer;
+
+enum class BlendMode : uint8_t {
+    Alpha,         // src * a + dst * (1 - a)
+    Premultiplied, // src + dst * (1 - a)
+};
+
+struct BatchVertex {
+    float x = 0.0f;
+    float y = 0.0f;
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 255;
+};
+
+// Collects a frame's triangles and lines into one vertex/color array and
+// submits them with as few draw calls as possible. Consecutive primitives of
+// the same kind share a draw call; a new one only starts when the primitive
+// kind, blend mode or (for lines) line width changes.
+//
+// On the core-profile backend the arrays are streamed through one VBO/EBO
+// pair and lines are expanded to quads, since wide lines are not available
+// there. Lines then share draw calls with triangles.
+class BatchRenderer {
+public:
+    bool InitCore();
+    void DestroyCore();
+
+    void Begin();
+    void Flush();
+
+    void SetBlend(BlendMode mode) { blend_ = mode; }
+    void SetLineWidth(float width) { lineWidth_ = width; }
+
+    // When the batch draws into an offscreen target that is composited
+    // later, alpha must accumulate as "over" so the target ends up holding
+    // premultiplied color.
+    void SetPremultipliedTarget(bool enabled) { premultipliedTarget_ = enabled; }
+
+    // With a software target set, Flush hands the batched triangles and
+    // lines to it instead of issuing GL calls.
+    void SetSoftwareTarget(SoftRasterizer* target) { software_ = target; }
+    SoftRasterizer* SoftwareTarget() const { return software_; }
+
+    uint32_t Vertex(float x, float y, const Color& c);
+    void TriangleIndices(uint32_t a, uint32_t b, uint32_t c);
+    void LineIndices(uint32_t a, uint32_t b);
+
+    void Triangle(float x0, float y0, float x1, float y1, float x2, float y2, const Color& c);
+    void Triangle(float x0, float y0, const Color& c0, float x1, float y1, const Color& c1, float x2, float y2, const Color& c2);
+    void Line(float x0, float y0, float x1, float y1, const Color& c);
+
+    size_t DrawCallsLastFlush() const { return drawCallsLastFlush_; }
+
+private:
+    struct Batch {
+        GLenum mode = GL_TRIANGLES;
+        BlendMode blend = BlendMode::Alpha;
+        float lineWidth = 1.0f;
+        size_t first = 0;
+        size_t count = 0;
+    };
+
+    Batch& Current(GLenum mode);
+    void LineQuad(uint32_t a, uint32_t b);
+    void SetBlendState(BlendMode mode) const;
+    void FlushLegacy();
+    void FlushCore();
+    void FlushSoftware();
+
+    std::vector<BatchVertex> vertices_;
+    std::vector<uint32_t> indices_;
+    std::vector<Batch> batches_;
+    BlendMode blend_ = BlendMode::Alpha;
+    float lineWidth_ = 1.0f;
+    bool premultipliedTarget_ = false;
+    SoftRasterizer* software_ = nullptr;
+    size_t drawCallsLastFlush_ = 0;
+
+    GLuint program_ = 0;
+    GLint viewportLoc_ = -1;
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+    GLuint ebo_ = 0;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+struct Color {
+    float r = 0.0f;
+    float g = 0.0f;
+    float b = 0.0f;
+    float a = 1.0f;
+};
+
+// A color as scene data stores it and as the GL backends' vertex formats
+// take it: 8 bits per channel, straight alpha.
+struct Rgba8 {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 255;
+};
+
+inline Color FromRGB(int r, int g, int b, float a = 1.0f) {
+    return {
+        r / 255.0f,
+        g / 255.0f,
+        b / 255.0f,
+        a,
+    };
+}
+
+inline uint8_t ToByte(float v) {
+    return static_cast<uint8_t>(std::max(0.0f, std::min(1.0f, v)) * 255.0f + 0.5f);
+}
+
+inline Rgba8 PackColor(const Color& c) {
+    return {ToByte(c.r), ToByte(c.g), ToByte(c.b), ToByte(c.a)};
+}
+
+// Exact inverse of PackColor for colors it produced.
+inline Color UnpackColor(Rgba8 c) {
+    return FromRGB(c.r, c.g, c.b, c.a / 255.0f);
+}
+
+inline Color AdjustColor(Color c, int delta) {
+    auto clamp01 = [](float v) { return std::max(0.0f, std::min(1.0f, v)); };
+    float d = delta / 255.0f;
+    c.r = clamp01(c.r + d);
+    c.g = clamp01(c.g + d);
+    c.b = clamp01(c.b + d);
+    return c;
+}
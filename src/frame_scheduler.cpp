@@ -0,0 +1,56 @@
+#include "frame_scheduler.h"
+
+#include <algorithm>
+
+void FrameScheduler::Start(double now) {
+    startTime_ = now;
+    lastFrameTime_ = -1.0e9;
+    ticked_ = false;
+    redrawForced_ = true;
+    stats_ = FrameStats{};
+}
+
+void FrameScheduler::Resume() {
+    redrawForced_ = true;
+}
+
+// Allow frames a little early so timer jitter does not push a frame a
+// whole tick late.
+static constexpr double kFrameSlack = 0.002;
+
+double FrameScheduler::WaitTimeout(double now) const {
+    if (redrawForced_) return 0.0;
+    double frameDue = lastFrameTime_ + frameInterval_ - kFrameSlack - now;
+    if (ticked_ || continuous_) return std::max(0.0, frameDue);
+    return std::max(tickInterval_, frameDue);
+}
+
+bool FrameScheduler::ShouldRender(double now) {
+    ++stats_.wakeups;
+    bool frameDue = now >= lastFrameTime_ + frameInterval_ - kFrameSlack;
+    if (!redrawForced_ && !((ticked_ || continuous_) && frameDue)) {
+        ++stats_.skipped;
+        return false;
+    }
+    redrawForced_ = false;
+    ticked_ = false;
+    lastFrameTime_ = now;
+    ++stats_.rendered;
+    return true;
+}
+
+void FrameScheduler::Report(std::FILE* out, double now, int refreshRate) const {
+    double elapsed = std::max(1e-9, now - startTime_);
+    double vsyncFrames = elapsed * refreshRate;
+    std::fprintf(
+        out,
+        "frames: %.1fs rendered=%llu (%.1f/s) skipped=%llu wakeups=%llu snapshots=%llu; vsync-driven loop would draw ~%.0f\n",
+        elapsed,
+        static_cast<unsigned long long>(stats_.rendered),
+        stats_.rendered / elapsed,
+        static_cast<unsigned long long>(stats_.skipped),
+        static_cast<unsigned long long>(stats_.wakeups),
+        static_cast<unsigned long long>(stats_.snapshots),
+        vsyncFrames);
+    std::fflush(out);
+}
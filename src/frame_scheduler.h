@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+struct FrameStats {
+    uint64_t wakeups = 0;
+    uint64_t rendered = 0;
+    uint64_t skipped = 0;   // wakeups that did not need a redraw
+    uint64_t snapshots = 0; // new simulation states received
+};
+
+// Drives the main loop off the simulation instead of vsync: the loop
+// sleeps until SimThread publishes a snapshot (it wakes the loop) or an
+// input event arrives, and a frame is only drawn when there is a new
+// snapshot or something asked for a redraw (expose, resize).
+//
+// In continuous mode (--interpolate) every frame shows a new blend between
+// the last two snapshots, so frames are drawn at the frame interval
+// whether or not a snapshot arrived.
+class FrameScheduler {
+public:
+    explicit FrameScheduler(double tickInterval) : tickInterval_(tickInterval) {}
+
+    void Start(double now);
+    double TickInterval() const { return tickInterval_; }
+    void SetTickInterval(double interval) { tickInterval_ = interval; }
+    void SetContinuous(bool continuous) { continuous_ = continuous; }
+
+    // Minimum spacing between tick-driven frames. Ticks that land inside
+    // the interval are simulated but drawn together with the next frame.
+    void SetFrameInterval(double interval) { frameInterval_ = interval; }
+
+    // Draws a frame as soon as the loop resumes after nothing was drawn.
+    void Resume();
+
+    // Seconds the loop may block. Zero means "poll": a redraw is pending,
+    // or a snapshot is waiting and the frame interval has passed. With
+    // nothing to draw it is one tick, as a bound in case the simulation's
+    // wake-up is lost.
+    double WaitTimeout(double now) const;
+
+    // AcquireSnapshot returned a new state.
+    void SnapshotArrived() {
+        ticked_ = true;
+        ++stats_.snapshots;
+    }
+
+    void RequestRedraw() { redrawForced_ = true; }
+
+    // Called once per loop iteration. Returns true if a frame should be
+    // drawn now and updates the counters either way.
+    bool ShouldRender(double now);
+
+    const FrameStats& Stats() const { return stats_; }
+    void Report(std::FILE* out, double now, int refreshRate) const;
+
+private:
+    double tickInterval_ = 1.0 / 30.0;
+    double startTime_ = 0.0;
+    double frameInterval_ = 0.0;
+    double lastFrameTime_ = -1.0e9;
+    bool ticked_ = false;
+    bool continuous_ = false;
+    bool redrawForced_ = true;
+    FrameStats stats_{};
+};
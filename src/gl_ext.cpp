@@ -0,0 +1,147 @@
+#include "gl_ext.h"
+
+#include <cstdio>
+#include <cstring>
+
+GLFunctions g_gl{};
+
+template <typename Fn>
+static bool Load(GLProcLoader loader, Fn& fn, const char* name) {
+    fn = reinterpret_cast<Fn>(loader(name));
+    return fn != nullptr;
+}
+
+static int GLMajorVersion() {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    int major = 0;
+    int minor = 0;
+    if (!version || std::sscanf(version, "%d.%d", &major, &minor) < 1) {
+        return 0;
+    }
+    return major;
+}
+
+static bool HasLegacyExtension(const char* name) {
+    const char* all = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    return all && std::strstr(all, name) != nullptr;
+}
+
+bool LoadGLFunctions(GLProcLoader loader, bool coreProfile) {
+    g_gl = GLFunctions{};
+    const int major = GLMajorVersion();
+    g_gl.coreProfile = coreProfile;
+
+    bool ok = Load(loader, g_gl.BlendFuncSeparate, "glBlendFuncSeparate");
+
+    bool fbo = true;
+    fbo &= Load(loader, g_gl.GenFramebuffers, "glGenFramebuffers");
+    fbo &= Load(loader, g_gl.DeleteFramebuffers, "glDeleteFramebuffers");
+    fbo &= Load(loader, g_gl.BindFramebuffer, "glBindFramebuffer");
+    fbo &= Load(loader, g_gl.FramebufferTexture2D, "glFramebufferTexture2D");
+    fbo &= Load(loader, g_gl.FramebufferRenderbuffer, "glFramebufferRenderbuffer");
+    fbo &= Load(loader, g_gl.CheckFramebufferStatus, "glCheckFramebufferStatus");
+    fbo &= Load(loader, g_gl.BlitFramebuffer, "glBlitFramebuffer");
+    fbo &= Load(loader, g_gl.GenRenderbuffers, "glGenRenderbuffers");
+    fbo &= Load(loader, g_gl.DeleteRenderbuffers, "glDeleteRenderbuffers");
+    fbo &= Load(loader, g_gl.BindRenderbuffer, "glBindRenderbuffer");
+    fbo &= Load(loader, g_gl.RenderbufferStorageMultisample, "glRenderbufferStorageMultisample");
+    g_gl.framebufferObject = fbo && ok && (major >= 3 || HasLegacyExtension("GL_ARB_framebuffer_object"));
+
+    bool timer = true;
+    timer &= Load(loader, g_gl.GenQueries, "glGenQueries");
+    timer &= Load(loader, g_gl.DeleteQueries, "glDeleteQueries");
+    timer &= Load(loader, g_gl.QueryCounter, "glQueryCounter");
+    timer &= Load(loader, g_gl.GetQueryObjectiv, "glGetQueryObjectiv");
+    timer &= Load(loader, g_gl.GetQueryObjectui64v, "glGetQueryObjectui64v");
+    // Core contexts are 3.3+, which includes timer queries; glGetString
+    // (GL_EXTENSIONS) is not available there.
+    g_gl.timerQuery = timer && (coreProfile || HasLegacyExtension("GL_ARB_timer_query"));
+
+    if (!coreProfile) {
+        return ok;
+    }
+
+    ok &= g_gl.framebufferObject && major >= 3;
+    ok &= Load(loader, g_gl.CreateShader, "glCreateShader");
+    ok &= Load(loader, g_gl.ShaderSource, "glShaderSource");
+    ok &= Load(loader, g_gl.CompileShader, "glCompileShader");
+    ok &= Load(loader, g_gl.GetShaderiv, "glGetShaderiv");
+    ok &= Load(loader, g_gl.GetShaderInfoLog, "glGetShaderInfoLog");
+    ok &= Load(loader, g_gl.DeleteShader, "glDeleteShader");
+    ok &= Load(loader, g_gl.CreateProgram, "glCreateProgram");
+    ok &= Load(loader, g_gl.AttachShader, "glAttachShader");
+    ok &= Load(loader, g_gl.BindAttribLocation, "glBindAttribLocation");
+    ok &= Load(loader, g_gl.LinkProgram, "glLinkProgram");
+    ok &= Load(loader, g_gl.GetProgramiv, "glGetProgramiv");
+    ok &= Load(loader, g_gl.GetProgramInfoLog, "glGetProgramInfoLog");
+    ok &= Load(loader, g_gl.DeleteProgram, "glDeleteProgram");
+    ok &= Load(loader, g_gl.UseProgram, "glUseProgram");
+    ok &= Load(loader, g_gl.GetUniformLocation, "glGetUniformLocation");
+    ok &= Load(loader, g_gl.Uniform1i, "glUniform1i");
+    ok &= Load(loader, g_gl.Uniform2f, "glUniform2f");
+    ok &= Load(loader, g_gl.Uniform1f, "glUniform1f");
+    ok &= Load(loader, g_gl.Uniform1ui, "glUniform1ui");
+    ok &= Load(loader, g_gl.Uniform4f, "glUniform4f");
+    ok &= Load(loader, g_gl.GenBuffers, "glGenBuffers");
+    ok &= Load(loader, g_gl.DeleteBuffers, "glDeleteBuffers");
+    ok &= Load(loader, g_gl.BindBuffer, "glBindBuffer");
+    ok &= Load(loader, g_gl.BufferData, "glBufferData");
+    ok &= Load(loader, g_gl.BufferSubData, "glBufferSubData");
+    ok &= Load(loader, g_gl.GenVertexArrays, "glGenVertexArrays");
+    ok &= Load(loader, g_gl.DeleteVertexArrays, "glDeleteVertexArrays");
+    ok &= Load(loader, g_gl.BindVertexArray, "glBindVertexArray");
+    ok &= Load(loader, g_gl.EnableVertexAttribArray, "glEnableVertexAttribArray");
+    ok &= Load(loader, g_gl.VertexAttribPointer, "glVertexAttribPointer");
+    ok &= Load(loader, g_gl.VertexAttribIPointer, "glVertexAttribIPointer");
+    ok &= Load(loader, g_gl.VertexAttribDivisor, "glVertexAttribDivisor");
+    ok &= Load(loader, g_gl.DrawArraysInstanced, "glDrawArraysInstanced");
+    return ok;
+}
+
+static GLuint CompileShader(GLenum type, const char* source) {
+    GLuint shader = g_gl.CreateShader(type);
+    g_gl.ShaderSource(shader, 1, &source, nullptr);
+    g_gl.CompileShader(shader);
+
+    GLint status = GL_FALSE;
+    g_gl.GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024] = {};
+        g_gl.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "shader compile failed: %s\n", log);
+        g_gl.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint BuildProgram(const char* vertexSource, const char* fragmentSource, const char* const* attributes, int attributeCount) {
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vs || !fs) {
+        if (vs) g_gl.DeleteShader(vs);
+        if (fs) g_gl.DeleteShader(fs);
+        return 0;
+    }
+
+    GLuint program = g_gl.CreateProgram();
+    g_gl.AttachShader(program, vs);
+    g_gl.AttachShader(program, fs);
+    for (int i = 0; i < attributeCount; ++i) {
+        g_gl.BindAttribLocation(program, static_cast<GLuint>(i), attributes[i]);
+    }
+    g_gl.LinkProgram(program);
+    g_gl.DeleteShader(vs);
+    g_gl.DeleteShader(fs);
+
+    GLint status = GL_FALSE;
+    g_gl.GetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024] = {};
+        g_gl.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "program link failed: %s\n", log);
+        g_gl.DeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "gl_platform.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Entry points above OpenGL 1.1 are not exported by every platform's GL
+// library (opengl32.dll stops at 1.1), so they are resolved at runtime.
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#endif
+#ifndef GL_READ_FRAMEBUFFER
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#endif
+#ifndef GL_DRAW_FRAMEBUFFER
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#endif
+#ifndef GL_RENDERBUFFER
+#define GL_RENDERBUFFER 0x8D41
+#endif
+#ifndef GL_COLOR_ATTACHMENT0
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+#ifndef GL_MAX_SAMPLES
+#define GL_MAX_SAMPLES 0x8D57
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER 0x8B31
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_INFO_LOG_LENGTH
+#define GL_INFO_LOG_LENGTH 0x8B84
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+using GLProc = void (*)();
+using GLProcLoader = GLProc (*)(const char*);
+
+struct GLFunctions {
+    // True when the context is a 3.3+ core profile: fixed-function calls are
+    // unavailable and everything is drawn through shaders and buffers.
+    bool coreProfile = false;
+    bool framebufferObject = false;
+    bool timerQuery = false; // GL 3.3 or ARB_timer_query
+
+    void(APIENTRY* BlendFuncSeparate)(GLenum, GLenum, GLenum, GLenum) = nullptr;
+
+    void(APIENTRY* GenFramebuffers)(GLsizei, GLuint*) = nullptr;
+    void(APIENTRY* DeleteFramebuffers)(GLsizei, const GLuint*) = nullptr;
+    void(APIENTRY* BindFramebuffer)(GLenum, GLuint) = nullptr;
+    void(APIENTRY* FramebufferTexture2D)(GLenum, GLenum, GLenum, GLuint, GLint) = nullptr;
+    void(APIENTRY* FramebufferRenderbuffer)(GLenum, GLenum, GLenum, GLuint) = nullptr;
+    GLenum(APIENTRY* CheckFramebufferStatus)(GLenum) = nullptr;
+    void(APIENTRY* BlitFramebuffer)(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum) = nullptr;
+    void(APIENTRY* GenRenderbuffers)(GLsizei, GLuint*) = nullptr;
+    void(APIENTRY* DeleteRenderbuffers)(GLsizei, const GLuint*) = nullptr;
+    void(APIENTRY* BindRenderbuffer)(GLenum, GLuint) = nullptr;
+    void(APIENTRY* RenderbufferStorageMultisample)(GLenum, GLsizei, GLenum, GLsizei, GLsizei) = nullptr;
+
+    void(APIENTRY* GenQueries)(GLsizei, GLuint*) = nullptr;
+    void(APIENTRY* DeleteQueries)(GLsizei, const GLuint*) = nullptr;
+    void(APIENTRY* QueryCounter)(GLuint, GLenum) = nullptr;
+    void(APIENTRY* GetQueryObjectiv)(GLuint, GLenum, GLint*) = nullptr;
+    void(APIENTRY* GetQueryObjectui64v)(GLuint, GLenum, uint64_t*) = nullptr;
+
+    GLuint(APIENTRY* CreateShader)(GLenum) = nullptr;
+    void(APIENTRY* ShaderSource)(GLuint, GLsizei, const char* const*, const GLint*) = nullptr;
+    void(APIENTRY* CompileShader)(GLuint) = nullptr;
+    void(APIENTRY* GetShaderiv)(GLuint, GLenum, GLint*) = nullptr;
+    void(APIENTRY* GetShaderInfoLog)(GLuint, GLsizei, GLsizei*, char*) = nullptr;
+    void(APIENTRY* DeleteShader)(GLuint) = nullptr;
+    GLuint(APIENTRY* CreateProgram)() = nullptr;
+    void(APIENTRY* AttachShader)(GLuint, GLuint) = nullptr;
+    void(APIENTRY* BindAttribLocation)(GLuint, GLuint, const char*) = nullptr;
+    void(APIENTRY* LinkProgram)(GLuint) = nullptr;
+    void(APIENTRY* GetProgramiv)(GLuint, GLenum, GLint*) = nullptr;
+    void(APIENTRY* GetProgramInfoLog)(GLuint, GLsizei, GLsizei*, char*) = nullptr;
+    void(APIENTRY* DeleteProgram)(GLuint) = nullptr;
+    void(APIENTRY* UseProgram)(GLuint) = nullptr;
+    GLint(APIENTRY* GetUniformLocation)(GLuint, const char*) = nullptr;
+    void(APIENTRY* Uniform1i)(GLint, GLint) = nullptr;
+    void(APIENTRY* Uniform2f)(GLint, GLfloat, GLfloat) = nullptr;
+    void(APIENTRY* Uniform1f)(GLint, GLfloat) = nullptr;
+    void(APIENTRY* Uniform1ui)(GLint, GLuint) = nullptr;
+    void(APIENTRY* Uniform4f)(GLint, GLfloat, GLfloat, GLfloat, GLfloat) = nullptr;
+
+    void(APIENTRY* GenBuffers)(GLsizei, GLuint*) = nullptr;
+    void(APIENTRY* DeleteBuffers)(GLsizei, const GLuint*) = nullptr;
+    void(APIENTRY* BindBuffer)(GLenum, GLuint) = nullptr;
+    void(APIENTRY* BufferData)(GLenum, std::ptrdiff_t, const void*, GLenum) = nullptr;
+    void(APIENTRY* BufferSubData)(GLenum, std::ptrdiff_t, std::ptrdiff_t, const void*) = nullptr;
+    void(APIENTRY* GenVertexArrays)(GLsizei, GLuint*) = nullptr;
+    void(APIENTRY* DeleteVertexArrays)(GLsizei, const GLuint*) = nullptr;
+    void(APIENTRY* BindVertexArray)(GLuint) = nullptr;
+    void(APIENTRY* EnableVertexAttribArray)(GLuint) = nullptr;
+    void(APIENTRY* VertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) = nullptr;
+    void(APIENTRY* VertexAttribIPointer)(GLuint, GLint, GLenum, GLsizei, const void*) = nullptr;
+    void(APIENTRY* VertexAttribDivisor)(GLuint, GLuint) = nullptr;
+    void(APIENTRY* DrawArraysInstanced)(GLenum, GLint, GLsizei, GLsizei) = nullptr;
+};
+
+extern GLFunctions g_gl;
+
+// Resolves g_gl for the current context. Returns false if the set the
+// requested backend cannot work without is missing; optional features are
+// flagged individually.
+bool LoadGLFunctions(GLProcLoader loader, bool coreProfile);
+
+// Compiles and links a program. Attribute names are bound to their index in
+// `attributes`. Returns 0 and logs to stderr on failure.
+GLuint BuildProgram(const char* vertexSource, const char* fragmentSource, const char* const* attributes, int attributeCount);
@@ -0,0 +1,115 @@
+#include "gpu_profiler.h"
+
+#include "profiler.h"
+
+#include <algorithm>
+
+GpuProfiler g_gpuProfiler;
+
+bool GpuProfiler::Init() {
+    Destroy();
+    if (!g_gl.timerQuery) return false;
+    for (Slot& slot : slots_) {
+        g_gl.GenQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+    }
+    current_ = 0;
+    ready_ = true;
+    return true;
+}
+
+void GpuProfiler::Destroy() {
+    if (ready_) {
+        for (Slot& slot : slots_) {
+            g_gl.DeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+            slot = Slot{};
+        }
+    }
+    ready_ = false;
+    recording_ = false;
+    openCount_ = 0;
+}
+
+void GpuProfiler::Harvest(Slot& slot) {
+    slot.pending = false;
+    std::array<uint64_t, 2 * kMaxPasses> stamps{};
+    for (int i = 0; i < slot.queryCount; ++i) {
+        g_gl.GetQueryObjectui64v(slot.queries[static_cast<size_t>(i)], GL_QUERY_RESULT, &stamps[static_cast<size_t>(i)]);
+    }
+
+    Profiler::FrameSample sample;
+    uint64_t first = UINT64_MAX;
+    uint64_t last = 0;
+    for (int i = 0; i < slot.passCount; ++i) {
+        const Pass& p = slot.passes[static_cast<size_t>(i)];
+        const uint64_t begin = stamps[static_cast<size_t>(p.begin)];
+        const uint64_t end = std::max(begin, stamps[static_cast<size_t>(p.end)]);
+        sample.stageMs[static_cast<size_t>(p.stage)] += static_cast<float>(end - begin) * 1.0e-6f;
+        first = std::min(first, begin);
+        last = std::max(last, end);
+    }
+    if (slot.passCount > 0) sample.busyMs = static_cast<float>(last - first) * 1.0e-6f;
+    g_profiler.AddGpuFrame(sample);
+}
+
+void GpuProfiler::BeginFrame() {
+    recording_ = false;
+    if (!Active()) return;
+
+    // Slots complete in submission order, so read back from the oldest and
+    // stop at the first one the GPU has not finished.
+    for (int i = 1; i <= kFramesInFlight; ++i) {
+        Slot& slot = slots_[static_cast<size_t>((current_ + i) % kFramesInFlight)];
+        if (!slot.pending) continue;
+        GLint available = 0;
+        g_gl.GetQueryObjectiv(slot.queries[static_cast<size_t>(slot.queryCount - 1)], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+        Harvest(slot);
+    }
+
+    current_ = (current_ + 1) % kFramesInFlight;
+    Slot& slot = slots_[static_cast<size_t>(current_)];
+    if (slot.pending) {
+        g_profiler.CountGpuDropped();
+        return;
+    }
+    slot.passCount = 0;
+    slot.queryCount = 0;
+    openCount_ = 0;
+    recording_ = true;
+}
+
+void GpuProfiler::EndFrame() {
+    if (!recording_) return;
+    recording_ = false;
+    Slot& slot = slots_[static_cast<size_t>(current_)];
+    slot.pending = slot.queryCount > 0;
+}
+
+int GpuProfiler::Stamp(Slot& slot) {
+    const int index = slot.queryCount++;
+    g_gl.QueryCounter(slot.queries[static_cast<size_t>(index)], GL_TIMESTAMP);
+    return index;
+}
+
+void GpuProfiler::BeginPass(int stage) {
+    if (!recording_) return;
+    Slot& slot = slots_[static_cast<size_t>(current_)];
+    int index = -1;
+    if (stage >= 0 && slot.passCount < kMaxPasses) {
+        index = slot.passCount++;
+        Pass& p = slot.passes[static_cast<size_t>(index)];
+        p.stage = stage;
+        p.begin = Stamp(slot);
+        p.end = p.begin;
+        g_profiler.MarkGpuStage(stage);
+    }
+    if (openCount_ < kMaxPasses) open_[static_cast<size_t>(openCount_++)] = index;
+}
+
+void GpuProfiler::EndPass() {
+    if (!recording_ || openCount_ == 0) return;
+    const int index = open_[static_cast<size_t>(--openCount_)];
+    if (index < 0) return;
+    Slot& slot = slots_[static_cast<size_t>(current_)];
+    slot.passes[static_cast<size_t>(index)].end = Stamp(slot);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "gl_ext.h"
+
+#include <array>
+#include <cstdint>
+
+// GPU time per render pass from GL_TIMESTAMP queries. Each pass writes a
+// timestamp when it begins and ends, so passes may nest. Queries live in a
+// ring of kFramesInFlight frame slots. A slot is only read back once its
+// last query reports GL_QUERY_RESULT_AVAILABLE, so the CPU never waits on
+// the GPU. If the GPU is more than kFramesInFlight frames behind, that
+// frame goes unmeasured and is counted as dropped. Finished frames go to
+// g_profiler, keyed by the same stage indices as the CPU markers.
+class GpuProfiler {
+public:
+    static constexpr int kFramesInFlight = 4;
+    static constexpr int kMaxPasses = 32; // per frame
+
+    // Needs g_gl.timerQuery; returns false (and stays inert) without it.
+    bool Init();
+    void Destroy();
+    bool Ready() const { return ready_; }
+
+    void SetEnabled(bool enabled) { enabled_ = enabled; }
+    bool Enabled() const { return enabled_; }
+    bool Active() const { return enabled_ && ready_; }
+
+    void BeginFrame();
+    void EndFrame();
+    void BeginPass(int stage);
+    void EndPass();
+
+private:
+    struct Pass {
+        int stage = -1;
+        int begin = 0; // query indices within the slot
+        int end = 0;
+    };
+
+    struct Slot {
+        std::array<GLuint, 2 * kMaxPasses> queries{};
+        std::array<Pass, kMaxPasses> passes{};
+        int passCount = 0;
+        int queryCount = 0;
+        bool pending = false;
+    };
+
+    void Harvest(Slot& slot);
+    int Stamp(Slot& slot);
+
+    std::array<Slot, kFramesInFlight> slots_{};
+    int current_ = 0;
+    bool recording_ = false;
+    std::array<int, kMaxPasses> open_{}; // pass indices of unfinished passes
+    int openCount_ = 0;
+    bool ready_ = false;
+    bool enabled_ = false;
+};
+
+extern GpuProfiler g_gpuProfiler;
@@ -0,0 +1,184 @@
+#include "gpu_snow.h"
+
+#include "tessellation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Ticks are folded into an epoch every 2^20 steps (about 9.7 hours at
+// 30 Hz) so the float phase keeps sub-pixel precision. The epoch is mixed
+// into the hash, so the field re-rolls once at each boundary.
+static constexpr double kEpochTicks = 1048576.0;
+
+static const char* kGpuSnowVertexShader = R"(#version 330 core
+uniform vec2 uViewport;
+uniform vec2 uField;
+uniform float uTick;
+uniform uint uEpoch;
+uniform vec4 uSmall;
+uniform vec4 uLarge;
+uniform float uPad;
+in vec2 aUnit;
+in uint aSeed;
+out vec4 vColor;
+out vec2 vLocal;
+flat out float vRadius;
+
+uint Hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float Unit(uint h) {
+    return float(h >> 8) * (1.0 / 16777216.0);
+}
+
+void main() {
+    uint seed = Hash(aSeed ^ (uEpoch * 0x9e3779b9u));
+    float speed = mix(0.5, 1.8, Unit(Hash(seed + 1u)));
+    float drift = mix(-0.3, 0.3, Unit(Hash(seed + 2u)));
+    float radius = floor(1.0 + 3.0 * Unit(Hash(seed + 3u)));
+
+    // One life is a fall from y = -30 to past the bottom edge at
+    // height + 10. The first life starts anywhere on screen, like the
+    // CPU path's initial scatter.
+    float span = uField.y + 40.0;
+    float phase = Unit(Hash(seed + 4u)) * span + uTick * speed;
+    float life = floor(phase / span);
+    float fallen = phase - life * span;
+    float y = fallen - 30.0;
+
+    // Each respawn re-rolls the column; drift accumulates only within the
+    // current life, and horizontal wrap is periodic over width + 15.
+    float x0 = Unit(Hash(seed ^ (uint(life) * 0x85ebca6bu + 5u))) * uField.x;
+    float x = x0 + drift * (fallen / speed);
+    x = mod(x + 10.0, uField.x + 15.0) - 10.0;
+
+    vLocal = aUnit * (radius + uPad);
+    vRadius = radius;
+    vec2 p = vec2(x, y) + vLocal;
+    vec2 ndc = p / uViewport * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    vColor = radius >= 3.0 ? uLarge : uSmall;
+}
+)";
+
+static const char* kGpuSnowFragmentShader = R"(#version 330 core
+in vec4 vColor;
+out vec4 fragColor;
+void main() {
+    fragColor = vColor;
+}
+)";
+
+// SDF mode, as in SnowRenderer.
+static const char* kGpuSnowSdfFragmentShader = R"(#version 330 core
+in vec4 vColor;
+in vec2 vLocal;
+flat in float vRadius;
+out vec4 fragColor;
+void main() {
+    float coverage = clamp(vRadius + 0.5 - length(vLocal), 0.0, 1.0);
+    if (coverage <= 0.0) discard;
+    fragColor = vec4(vColor.rgb, vColor.a * coverage);
+}
+)";
+
+bool GpuSnow::Init(bool sdf) {
+    const char* attributes[] = {"aUnit", "aSeed"};
+    program_ = BuildProgram(kGpuSnowVertexShader, sdf ? kGpuSnowSdfFragmentShader : kGpuSnowFragmentShader, attributes, 2);
+    if (!program_) {
+        return false;
+    }
+    viewportLoc_ = g_gl.GetUniformLocation(program_, "uViewport");
+    fieldLoc_ = g_gl.GetUniformLocation(program_, "uField");
+    tickLoc_ = g_gl.GetUniformLocation(program_, "uTick");
+    epochLoc_ = g_gl.GetUniformLocation(program_, "uEpoch");
+    smallLoc_ = g_gl.GetUniformLocation(program_, "uSmall");
+    largeLoc_ = g_gl.GetUniformLocation(program_, "uLarge");
+    g_gl.UseProgram(program_);
+    g_gl.Uniform1f(g_gl.GetUniformLocation(program_, "uPad"), sdf ? 1.0f : 0.0f);
+    g_gl.UseProgram(0);
+
+    const CircleLod& lod = CircleLodForRadius(3.0f);
+    std::vector<float> mesh;
+    if (sdf) {
+        mesh = {-1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f};
+    } else {
+        mesh.reserve(static_cast<size_t>(lod.segments) * 2 + 4);
+        mesh.push_back(0.0f);
+        mesh.push_back(0.0f);
+        mesh.insert(mesh.end(), lod.xy, lod.xy + lod.segments * 2);
+        mesh.push_back(lod.xy[0]);
+        mesh.push_back(lod.xy[1]);
+    }
+    meshVertexCount_ = static_cast<GLsizei>(mesh.size() / 2);
+
+    g_gl.GenVertexArrays(1, &vao_);
+    g_gl.GenBuffers(1, &meshVbo_);
+    g_gl.GenBuffers(1, &seedVbo_);
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, meshVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(mesh.size() * sizeof(float)), mesh.data(), GL_STATIC_DRAW);
+    g_gl.EnableVertexAttribArray(0);
+    g_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, seedVbo_);
+    g_gl.EnableVertexAttribArray(1);
+    g_gl.VertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(uint32_t), nullptr);
+    g_gl.VertexAttribDivisor(1, 1);
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void GpuSnow::Destroy() {
+    if (seedVbo_) g_gl.DeleteBuffers(1, &seedVbo_);
+    if (meshVbo_) g_gl.DeleteBuffers(1, &meshVbo_);
+    if (vao_) g_gl.DeleteVertexArrays(1, &vao_);
+    if (program_) g_gl.DeleteProgram(program_);
+    seedVbo_ = 0;
+    meshVbo_ = 0;
+    vao_ = 0;
+    program_ = 0;
+    count_ = 0;
+}
+
+void GpuSnow::Upload(const std::vector<uint32_t>& seeds) {
+    if (!program_) {
+        return;
+    }
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, seedVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(seeds.size() * sizeof(uint32_t)), seeds.data(), GL_STATIC_DRAW);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    count_ = seeds.size();
+}
+
+void GpuSnow::Draw(double tick, float width, float height, const Color& small, const Color& large) {
+    if (count_ == 0 || !program_) {
+        return;
+    }
+
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    g_gl.UseProgram(program_);
+    g_gl.Uniform2f(viewportLoc_, static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    g_gl.Uniform2f(fieldLoc_, width, height);
+    // An interpolated tick can dip just below zero right after a reseed.
+    tick = std::max(0.0, tick);
+    const double epoch = std::floor(tick / kEpochTicks);
+    g_gl.Uniform1f(tickLoc_, static_cast<float>(tick - epoch * kEpochTicks));
+    g_gl.Uniform1ui(epochLoc_, static_cast<GLuint>(epoch));
+    g_gl.Uniform4f(smallLoc_, small.r, small.g, small.b, small.a);
+    g_gl.Uniform4f(largeLoc_, large.r, large.g, large.b, large.a);
+    g_gl.BindVertexArray(vao_);
+    g_gl.DrawArraysInstanced(GL_TRIANGLE_FAN, 0, meshVertexCount_, static_cast<GLsizei>(count_));
+    g_gl.BindVertexArray(0);
+    g_gl.UseProgram(0);
+}
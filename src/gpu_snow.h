@@ -0,0 +1,50 @@
+#pragma once
+
+#include "color.h"
+#include "gl_ext.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Core-profile only. Snow with no CPU-side simulation: the instance buffer
+// only holds one 32-bit seed per flake and is uploaded when the scene
+// changes. The vertex shader hashes the seed into speed, drift and size,
+// then derives the flake's position, wraps and respawns in closed form
+// from the tick count. Each frame costs a few uniforms and one instanced
+// draw, whatever the flake count.
+//
+// Motion follows the CPU path's rules, but where RespawnFlake re-rolls a
+// flake's speed, drift and size, here they stay fixed for the flake's
+// lifetime and only its column is re-rolled. That keeps the fall period
+// constant and the position computable from time.
+// Init(true) draws the --aa=sdf quads, as SnowRenderer does.
+class GpuSnow {
+public:
+    bool Init(bool sdf);
+    void Destroy();
+    bool Ready() const { return program_ != 0; }
+
+    // Replaces the instance buffer; seeds are drawn by the scene (see
+    // AppState::snowSeeds).
+    void Upload(const std::vector<uint32_t>& seeds);
+    size_t Count() const { return count_; }
+
+    // `tick` counts 30 Hz steps since the seeds were drawn; fractions
+    // place the flakes between steps.
+    void Draw(double tick, float width, float height, const Color& small, const Color& large);
+
+private:
+    GLuint program_ = 0;
+    GLint viewportLoc_ = -1;
+    GLint fieldLoc_ = -1;
+    GLint tickLoc_ = -1;
+    GLint epochLoc_ = -1;
+    GLint smallLoc_ = -1;
+    GLint largeLoc_ = -1;
+    GLuint vao_ = 0;
+    GLuint meshVbo_ = 0;
+    GLuint seedVbo_ = 0;
+    GLsizei meshVertexCount_ = 0;
+    size_t count_ = 0;
+};
@@ -0,0 +1,140 @@
+#include "headless_context.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef XMASS_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static GLProc HeadlessGetProcAddress(const char* name) {
+    return reinterpret_cast<GLProc>(eglGetProcAddress(name));
+}
+
+// Prefers Mesa's surfaceless platform, which needs neither X11 nor a GPU,
+// and falls back to the default display.
+static EGLDisplay OpenDisplay() {
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        EGLint major = 0, minor = 0;
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor)) {
+            return display;
+        }
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        return EGL_NO_DISPLAY;
+    }
+    return display;
+}
+
+bool HeadlessContext::Create(int width, int height, bool core, int samples) {
+    Destroy();
+    EGLDisplay display = OpenDisplay();
+    if (display == EGL_NO_DISPLAY) {
+        std::fprintf(stderr, "headless: no EGL display\n");
+        return false;
+    }
+    display_ = display;
+    eglBindAPI(EGL_OPENGL_API);
+
+    EGLConfig config = nullptr;
+    EGLint found = 0;
+    for (int trySamples : {samples, 0}) {
+        const EGLint attributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_SAMPLE_BUFFERS, trySamples > 0 ? 1 : 0,
+            EGL_SAMPLES, trySamples,
+            EGL_NONE,
+        };
+        if (eglChooseConfig(display, attributes, &config, 1, &found) && found > 0) break;
+    }
+    if (found == 0) {
+        std::fprintf(stderr, "headless: no RGBA8 pbuffer config\n");
+        Destroy();
+        return false;
+    }
+
+    const EGLint surfaceAttributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (surface == EGL_NO_SURFACE) {
+        std::fprintf(stderr, "headless: cannot create a %dx%d pbuffer\n", width, height);
+        Destroy();
+        return false;
+    }
+    surface_ = surface;
+
+    const EGLint coreAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    const EGLint legacyAttributes[] = {EGL_NONE};
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, core ? coreAttributes : legacyAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        Destroy();
+        return false;
+    }
+    context_ = context;
+    width_ = width;
+    height_ = height;
+    MakeCurrent();
+    return true;
+}
+
+void HeadlessContext::Destroy() {
+    EGLDisplay display = static_cast<EGLDisplay>(display_);
+    if (!display) return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context_) eglDestroyContext(display, static_cast<EGLContext>(context_));
+    if (surface_) eglDestroySurface(display, static_cast<EGLSurface>(surface_));
+    eglTerminate(display);
+    display_ = nullptr;
+    surface_ = nullptr;
+    context_ = nullptr;
+}
+
+void HeadlessContext::MakeCurrent() {
+    EGLSurface surface = static_cast<EGLSurface>(surface_);
+    eglMakeCurrent(static_cast<EGLDisplay>(display_), surface, surface, static_cast<EGLContext>(context_));
+}
+
+GLProcLoader HeadlessContext::Loader() {
+    return HeadlessGetProcAddress;
+}
+
+#else
+
+bool HeadlessContext::Create(int, int, bool, int) {
+    std::fprintf(stderr, "headless: this build has no EGL support\n");
+    return false;
+}
+
+void HeadlessContext::Destroy() {}
+void HeadlessContext::MakeCurrent() {}
+
+GLProcLoader HeadlessContext::Loader() {
+    return nullptr;
+}
+
+#endif
+
+void HeadlessContext::ReadRGBA(unsigned char* out) const {
+    const size_t stride = static_cast<size_t>(width_) * 4;
+    std::vector<unsigned char> rows(stride * static_cast<size_t>(height_));
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, rows.data());
+    for (int y = 0; y < height_; ++y) {
+        std::memcpy(out + stride * y, rows.data() + stride * (height_ - 1 - y), stride);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "gl_ext.h"
+
+// An offscreen GL context with no window or display server, backed by an
+// EGL pbuffer. Only available when built with EGL (XMASS_HAVE_EGL). The
+// pbuffer is the default framebuffer, so the normal frame path renders
+// into it unchanged and the result is read back with ReadRGBA.
+class HeadlessContext {
+public:
+    ~HeadlessContext() { Destroy(); }
+
+    // Tries for a 3.3 core context when `core` is set, otherwise a
+    // compatibility context that the legacy path can use.
+    bool Create(int width, int height, bool core, int samples);
+    void Destroy();
+    void MakeCurrent();
+
+    static GLProcLoader Loader();
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+
+    // Reads the framebuffer into `out` (width * height * 4 bytes),
+    // top row first.
+    void ReadRGBA(unsigned char* out) const;
+
+private:
+    void* display_ = nullptr;
+    void* surface_ = nullptr;
+    void* context_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+};
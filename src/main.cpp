@@ -1,7 +1,3 @@
-#ifdef __APPLE__
-#define GL_SILENCE_DEPRECATION
-#endif
-
 #ifdef _WIN32
 #ifndef NOMINMAX
 #define NOMINMAX
@@ -11,11 +7,15 @@
 #include <winreg.h>
 #endif
 
-#include <GLFW/glfw3.h>
-
-#ifndef GL_MULTISAMPLE
-#define GL_MULTISAMPLE 0x809D
-#endif
+#include "frame_scheduler.h"
+#include "gpu_profiler.h"
+#include "headless_context.h"
+#include "power_policy.h"
+#include "profiler.h"
+#include "scene.h"
+#include "sim_thread.h"
+#include "soft_rasterizer.h"
+#include "x11_presenter.h"
 
 #ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -27,89 +27,92 @@
 #include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
-struct Color {
-    float r = 0.0f;
-    float g = 0.0f;
-    float b = 0.0f;
-    float a = 1.0f;
+enum class RenderBackend {
+    Auto,     // core profile when available, legacy otherwise
+    Core,     // OpenGL 3.3 core profile, instanced ornaments and snow
+    Legacy,   // OpenGL 2.1 fixed function
+    Software, // SoftRasterizer on the CPU, presented with X11 or headless
 };
 
-static Color FromRGB(int r, int g, int b, float a = 1.0f) {
-    return {
-        r / 255.0f,
-        g / 255.0f,
-        b / 255.0f,
-        a,
-    };
-}
-
-static int ClampInt(int v, int lo, int hi) {
-    return std::max(lo, std::min(hi, v));
-}
-
-static Color AdjustColor(Color c, int delta) {
-    auto clamp01 = [](float v) { return std::max(0.0f, std::min(1.0f, v)); };
-    float d = delta / 255.0f;
-    c.r = clamp01(c.r + d);
-    c.g = clamp01(c.g + d);
-    c.b = clamp01(c.b + d);
-    return c;
-}
-
-struct Ornament {
-    float x = 0.0f;
-    float y = 0.0f;
-    float radius = 6.0f;
-    Color colorA{};
-    Color colorB{};
-    bool on = true;
+struct AppOptions {
+    RenderBackend backend = RenderBackend::Auto;
+    bool stats = false;
+    bool seeded = false;
+    uint64_t seed = 0;
+    int threads = 0; // 0 uses every hardware thread
+    int simHz = 30;
+    int headlessWidth = 0; // > 0 renders offscreen instead of opening a window
+    int headlessHeight = 0;
+    int frames = 300;
+    const char* dumpPrefix = nullptr;
+    bool hud = false;
+    const char* tracePath = nullptr;
+    int traceFrames = 300;
+    bool gpuProfile = false;
+    const char* scenePath = nullptr;     // --scene: start from this file
+    const char* saveScenePath = nullptr; // --save-scene: written at startup and on S
+    bool startupReport = false;
 };
 
-struct Snowflake {
-    float x = 0.0f;
-    float y = 0.0f;
-    float speed = 0.8f;
-    float drift = 0.0f;
-    float radius = 2.0f;
-};
+// --startup-report: wall time of each startup phase, from entering main()
+// to the first frame on screen (or rendered, headless). Printed once after
+// that frame as "startup: phase=NAME ms=…" lines and a total, plus a
+// "startup: background=NAME ms=…" line for work that overlapped them.
+class StartupTimeline {
+public:
+    void Start() { start_ = last_ = Clock::now(); }
+
+    // Ends the phase running since the previous Mark (or Start).
+    void Mark(const char* phase) {
+        const Clock::time_point now = Clock::now();
+        if (count_ < kMaxPhases) {
+            phases_[count_++] = {phase, std::chrono::duration<double, std::milli>(now - last_).count(), false};
+        }
+        last_ = now;
+    }
 
-struct TreeLayer {
-    float y0 = 0.0f;
-    float y1 = 0.0f;
-    float halfW = 0.0f;
-};
+    void Background(const char* job, double ms) {
+        if (count_ < kMaxPhases) {
+            phases_[count_++] = {job, ms, true};
+        }
+    }
 
-struct NeedleStroke {
-    float x1 = 0.0f;
-    float y1 = 0.0f;
-    float x2 = 0.0f;
-    float y2 = 0.0f;
-    Color c{};
-};
+    void Report(std::FILE* out) const {
+        for (int i = 0; i < count_; ++i) {
+            std::fprintf(out, "startup: %s=%s ms=%.3f\n", phases_[i].background ? "background" : "phase", phases_[i].name, phases_[i].ms);
+        }
+        std::fprintf(out, "startup: total_ms=%.3f\n", std::chrono::duration<double, std::milli>(last_ - start_).count());
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int kMaxPhases = 16;
 
-struct AppState {
-    int width = 800;
-    int height = 600;
-    int blinkPhase = 0;
-    int layerCount = 6;
-    float treeCx = 400.0f;
-    float treeTopY = 60.0f;
-    float treeBottomY = 480.0f;
-    float treeBaseHalfW = 200.0f;
-    float layerHeight = 80.0f;
-    float layerOverlap = 40.0f;
-    std::vector<TreeLayer> layers;
-    std::vector<NeedleStroke> needles;
-    std::vector<Ornament> ornaments;
-    std::vector<Snowflake> snowflakes;
-    std::mt19937 rng{std::random_device{}()};
+    struct Phase {
+        const char* name = "";
+        double ms = 0.0;
+        bool background = false;
+    };
+    Phase phases_[kMaxPhases];
+    int count_ = 0;
+    Clock::time_point start_{};
+    Clock::time_point last_{};
 };
 
-static AppState g_state{};
+static AppOptions g_options{};
+static StartupTimeline g_startup;
+static X11Presenter g_presenter;
+static FrameScheduler g_scheduler{1.0 / 30.0};
+static SimThread g_sim;
+static PowerPolicy g_power;
 static bool g_clickThrough = false;
 static bool g_dragging = false;
 static double g_dragStartScreenX = 0.0;
@@ -451,417 +454,14 @@ static bool InitTray(GLFWwindow* overlayWindow) {
 }
 #endif
 
-static float RandFloat(std::mt19937& rng, float lo, float hi) {
-    std::uniform_real_distribution<float> dist(lo, hi);
-    return dist(rng);
-}
-
-static int RandInt(std::mt19937& rng, int lo, int hi) {
-    std::uniform_int_distribution<int> dist(lo, hi);
-    return dist(rng);
-}
-
-static void RebuildTreeGeometry() {
-    const int w = g_state.width;
-    const int h = g_state.height;
-
-    g_state.treeCx = w * 0.5f;
-    g_state.treeTopY = h * 0.11f;
-    g_state.treeBottomY = h * 0.80f;
-    g_state.treeBaseHalfW = w * 0.30f;
-
-    g_state.layerCount = ClampInt(w / 70, 5, 9);
-    g_state.layerHeight = (g_state.treeBottomY - g_state.treeTopY) / static_cast<float>(g_state.layerCount);
-    g_state.layerOverlap = g_state.layerHeight * 0.65f;
-
-    g_state.layers.clear();
-    g_state.layers.reserve(static_cast<size_t>(g_state.layerCount));
-
-    for (int i = 0; i < g_state.layerCount; ++i) {
-        float y0 = g_state.treeTopY + i * g_state.layerHeight;
-        float y1 = (i == g_state.layerCount - 1) ? g_state.treeBottomY : (y0 + g_state.layerHeight + g_state.layerOverlap);
-        float progress = static_cast<float>(i + 1) / static_cast<float>(g_state.layerCount);
-        float halfW = g_state.treeBaseHalfW * std::pow(progress, 1.25f);
-        g_state.layers.push_back({y0, y1, halfW});
-    }
-}
-
-static float TreeHalfWidthAtY(float y) {
-    float maxW = 0.0f;
-    for (const auto& layer : g_state.layers) {
-        if (y < layer.y0 || y > layer.y1) continue;
-        float denom = std::max(1.0f, layer.y1 - layer.y0);
-        float t = (y - layer.y0) / denom;
-        float w = t * layer.halfW;
-        maxW = std::max(maxW, w);
-    }
-    return maxW;
-}
-
-static void RegenerateScene(int w, int h) {
-    g_state.width = std::max(200, w);
-    g_state.height = std::max(200, h);
-
-    const int width = g_state.width;
-    const int height = g_state.height;
-
-    RebuildTreeGeometry();
-
-    const int ornamentCount = ClampInt((width * height) / 25000, 35, 140);
-    g_state.ornaments.clear();
-    g_state.ornaments.reserve(ornamentCount);
-
-    std::array<Color, 6> palette = {
-        FromRGB(255, 60, 60),   // red
-        FromRGB(60, 220, 80),   // green
-        FromRGB(255, 210, 60),  // gold
-        FromRGB(80, 160, 255),  // blue
-        FromRGB(255, 120, 240), // pink
-        FromRGB(255, 255, 255), // white
-    };
-
-    for (int i = 0; i < ornamentCount; ++i) {
-        float t = std::pow(RandFloat(g_state.rng, 0.0f, 1.0f), 0.70f);
-        float y = g_state.treeTopY + t * (g_state.treeBottomY - g_state.treeTopY);
-        float halfW = TreeHalfWidthAtY(y) * 0.92f;
-        float x = g_state.treeCx + RandFloat(g_state.rng, -halfW, halfW);
-
-        Ornament o;
-        o.x = x;
-        o.y = y;
-        o.radius = static_cast<float>(RandInt(g_state.rng, 4, 9));
-        int idxA = RandInt(g_state.rng, 0, static_cast<int>(palette.size() - 1));
-        int idxB = RandInt(g_state.rng, 0, static_cast<int>(palette.size() - 1));
-        o.colorA = palette[idxA];
-        o.colorB = palette[idxB];
-        o.on = RandInt(g_state.rng, 0, 1) == 1;
-        g_state.ornaments.push_back(o);
-    }
-
-    const int needleCount = ClampInt((width * height) / 900, 300, 2000);
-    g_state.needles.clear();
-    g_state.needles.reserve(static_cast<size_t>(needleCount));
-    for (int i = 0; i < needleCount; ++i) {
-        float t = std::pow(RandFloat(g_state.rng, 0.0f, 1.0f), 0.85f);
-        float y = g_state.treeTopY + t * (g_state.treeBottomY - g_state.treeTopY);
-        float halfW = TreeHalfWidthAtY(y) * 0.95f;
-        if (halfW < 6.0f) continue;
-        float x = g_state.treeCx + RandFloat(g_state.rng, -halfW, halfW);
-
-        float dir = (x < g_state.treeCx) ? -1.0f : 1.0f;
-        float len = RandFloat(g_state.rng, 2.5f, 6.5f);
-        float dy = RandFloat(g_state.rng, -1.4f, 1.4f);
-        float dx = dir * len;
-
-        NeedleStroke n;
-        n.x1 = x;
-        n.y1 = y;
-        n.x2 = x + dx;
-        n.y2 = y + dy;
-        n.c = AdjustColor(FromRGB(8, 120, 45), RandInt(g_state.rng, -22, 26));
-        n.c.a = 0.55f;
-        g_state.needles.push_back(n);
-    }
-
-    const int snowCount = ClampInt(width / 8, 60, 220);
-    g_state.snowflakes.clear();
-    g_state.snowflakes.reserve(snowCount);
-    for (int i = 0; i < snowCount; ++i) {
-        Snowflake s;
-        s.x = RandFloat(g_state.rng, 0.0f, static_cast<float>(width));
-        s.y = RandFloat(g_state.rng, 0.0f, static_cast<float>(height));
-        s.speed = RandFloat(g_state.rng, 0.5f, 1.8f);
-        s.drift = RandFloat(g_state.rng, -0.3f, 0.3f);
-        s.radius = static_cast<float>(RandInt(g_state.rng, 1, 3));
-        g_state.snowflakes.push_back(s);
-    }
-}
-
-static void SetColor(const Color& c) {
-    glColor4f(c.r, c.g, c.b, c.a);
-}
-
-static void DrawCircle(float cx, float cy, float r, const Color& c, int segments = 28) {
-    SetColor(c);
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(cx, cy);
-    for (int i = 0; i <= segments; ++i) {
-        float a = static_cast<float>(i) / segments * 2.0f * 3.1415926f;
-        glVertex2f(cx + std::cos(a) * r, cy + std::sin(a) * r);
-    }
-    glEnd();
-}
-
-static void DrawStar(float cx, float cy, float rOuter, float rInner, const Color& c) {
-    constexpr float pi = 3.1415926f;
-    std::array<std::pair<float, float>, 10> pts{};
-    for (int i = 0; i < 10; ++i) {
-        float angle = (i * 36.0f - 90.0f) * pi / 180.0f;
-        float r = (i % 2 == 0) ? rOuter : rInner;
-        pts[i] = {cx + std::cos(angle) * r, cy + std::sin(angle) * r};
-    }
-
-    SetColor(c);
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(cx, cy);
-    for (int i = 0; i < 10; ++i) {
-        glVertex2f(pts[i].first, pts[i].second);
-    }
-    glVertex2f(pts[0].first, pts[0].second);
-    glEnd();
-}
-
-static void DrawSolidTriangle(float x0, float y0, float x1, float y1, float x2, float y2, const Color& c) {
-    SetColor(c);
-    glBegin(GL_TRIANGLES);
-    glVertex2f(x0, y0);
-    glVertex2f(x1, y1);
-    glVertex2f(x2, y2);
-    glEnd();
-}
-
-static void DrawTriangleGradient(float x0, float y0, float x1, float y1, float x2, float y2, const Color& c0, const Color& c1, const Color& c2) {
-    glBegin(GL_TRIANGLES);
-    SetColor(c0);
-    glVertex2f(x0, y0);
-    SetColor(c1);
-    glVertex2f(x1, y1);
-    SetColor(c2);
-    glVertex2f(x2, y2);
-    glEnd();
-}
-
-static void DrawNeedles() {
-    glLineWidth(1.0f);
-    glBegin(GL_LINES);
-    for (const auto& n : g_state.needles) {
-        SetColor(n.c);
-        glVertex2f(n.x1, n.y1);
-        glVertex2f(n.x2, n.y2);
-    }
-    glEnd();
-}
-
-static void DrawLayerGarland(int layerIndex, float y0, float y1, float halfW) {
-    float garlandY = y0 + (y1 - y0) * 0.72f;
-    float t = (garlandY - y0) / std::max(1.0f, (y1 - y0));
-    float garlandHalfW = t * halfW;
-    int segments = ClampInt(static_cast<int>(halfW / 10.0f), 18, 32);
-    std::array<std::pair<float, float>, 40> pts{};
-
-    float phase = g_state.blinkPhase * 0.10f + layerIndex * 0.6f;
-    for (int i = 0; i <= segments; ++i) {
-        float u = static_cast<float>(i) / segments;
-        float x = g_state.treeCx - garlandHalfW + u * garlandHalfW * 2.0f;
-        float wave = std::sin(u * 3.1415926f * 2.0f + phase) * (g_state.layerHeight * 0.10f);
-        pts[static_cast<size_t>(i)] = {x, garlandY + wave};
-    }
-
-    Color garlandColor = FromRGB(255, 210, 80);
-    garlandColor.a = 0.9f;
-    glLineWidth(2.0f);
-    SetColor(garlandColor);
-    glBegin(GL_LINE_STRIP);
-    for (int i = 0; i <= segments; ++i) {
-        auto p = pts[static_cast<size_t>(i)];
-        glVertex2f(p.first, p.second);
-    }
-    glEnd();
-
-    for (int i = 0; i <= segments; i += 3) {
-        auto p = pts[static_cast<size_t>(i)];
-        float r = 2.7f + (i % 2);
-        bool on = ((g_state.blinkPhase / 6 + i + layerIndex * 2) % 2) == 0;
-        Color bead = on ? FromRGB(255, 80, 80) : FromRGB(240, 240, 255);
-        bead.a = on ? 1.0f : 0.9f;
-        DrawCircle(p.first, p.second, r, bead, 18);
-    }
-}
-
-static void DrawTree() {
-    const float cx = g_state.treeCx;
-    const float topY = g_state.treeTopY;
-    const float bottomY = g_state.treeBottomY;
-
-    Color baseGreen = FromRGB(8, 120, 45);
-    Color outline = FromRGB(5, 80, 30, 0.55f);
-
-    // soft shadow behind the tree
-    Color shadow = FromRGB(0, 0, 0, 0.16f);
-    for (int i = g_state.layerCount - 1; i >= 0; --i) {
-        const auto& layer = g_state.layers[static_cast<size_t>(i)];
-        float y0 = layer.y0 + 5.0f;
-        float y1 = layer.y1 + 5.0f;
-        float hw = layer.halfW + 5.0f;
-        DrawSolidTriangle(cx, y0, cx - hw, y1, cx + hw, y1, shadow);
-    }
-
-    // trunk behind branches
-    float trunkW = g_state.treeBaseHalfW * 0.28f;
-    float trunkH = (bottomY - topY) * 0.18f;
-    float trunkTop = bottomY - trunkH * 0.15f;
-    Color trunkTopC = FromRGB(150, 88, 38);
-    Color trunkBottomC = FromRGB(92, 48, 18);
-    glBegin(GL_QUADS);
-    SetColor(trunkTopC);
-    glVertex2f(cx - trunkW / 2.0f, trunkTop);
-    glVertex2f(cx + trunkW / 2.0f, trunkTop);
-    SetColor(trunkBottomC);
-    glVertex2f(cx + trunkW / 2.0f, trunkTop + trunkH);
-    glVertex2f(cx - trunkW / 2.0f, trunkTop + trunkH);
-    glEnd();
-
-    glLineWidth(2.0f);
-
-    // layers from bottom -> top for correct overlap
-    for (int i = g_state.layerCount - 1; i >= 0; --i) {
-        const auto& layer = g_state.layers[static_cast<size_t>(i)];
-        float y0 = layer.y0;
-        float y1 = layer.y1;
-        float hw = layer.halfW;
-
-        float x0 = cx;
-        float x1 = cx - hw;
-        float x2 = cx + hw;
-
-        Color topC = AdjustColor(baseGreen, 40 - i * 4);
-        Color bottomC = AdjustColor(baseGreen, -18 - i * 3);
-
-        DrawTriangleGradient(x0, y0, x1, y1, x2, y1, topC, bottomC, bottomC);
-
-        // subtle depth: darker underside near the bottom edge
-        float shadeH = std::max(10.0f, g_state.layerHeight * 0.28f);
-        Color underside = FromRGB(0, 0, 0, 0.08f);
-        DrawSolidTriangle(x0, y1 - shadeH * 0.55f, x1, y1, x2, y1, underside);
-
-        // inner sheen to make it feel less flat
-        Color sheen = AdjustColor(topC, 50);
-        sheen.a = 0.10f;
-        float innerScale = 0.55f;
-        DrawTriangleGradient(
-            x0,
-            y0 + g_state.layerHeight * 0.10f,
-            cx - hw * innerScale,
-            y1 - g_state.layerHeight * 0.15f,
-            cx + hw * innerScale,
-            y1 - g_state.layerHeight * 0.15f,
-            sheen,
-            sheen,
-            sheen);
-
-        // branch fringe along the bottom edge for a more realistic silhouette
-        int fringeCount = ClampInt(static_cast<int>(hw / 12.0f), 10, 26);
-        float fringeAmp = std::max(8.0f, g_state.layerHeight * 0.22f);
-        for (int j = 0; j < fringeCount; ++j) {
-            float u0 = static_cast<float>(j) / fringeCount;
-            float u2 = static_cast<float>(j + 1) / fringeCount;
-            float u1 = (u0 + u2) * 0.5f;
-            float bx0 = cx - hw + u0 * hw * 2.0f;
-            float bx2 = cx - hw + u2 * hw * 2.0f;
-            float bxc = cx - hw + u1 * hw * 2.0f;
-            float baseY = y1 - 1.0f;
-            float wobble = std::sin((u1 * 3.1415926f * 2.0f) + i * 0.8f) * (fringeAmp * 0.18f);
-            float tipY = y1 + fringeAmp * (0.55f + 0.45f * std::sin(j * 0.9f + i * 0.7f)) + wobble;
-            Color fringe = AdjustColor(bottomC, -10);
-            fringe.a = 0.96f;
-            DrawSolidTriangle(bx0, baseY, bxc, tipY, bx2, baseY, fringe);
-        }
-
-        // outline and highlights
-        SetColor(outline);
-        glBegin(GL_LINE_STRIP);
-        glVertex2f(x1, y1);
-        glVertex2f(x0, y0);
-        glVertex2f(x2, y1);
-        glEnd();
-
-        Color highlight = AdjustColor(baseGreen, 85);
-        highlight.a = 0.60f;
-        SetColor(highlight);
-        glBegin(GL_LINES);
-        glVertex2f(x0, y0);
-        glVertex2f(x1 + hw * 0.12f, y1 - g_state.layerHeight * 0.08f);
-        glVertex2f(x0, y0);
-        glVertex2f(x2 - hw * 0.12f, y1 - g_state.layerHeight * 0.08f);
-        glEnd();
-    }
-
-    DrawNeedles();
-
-    for (int i = g_state.layerCount - 1; i >= 0; --i) {
-        const auto& layer = g_state.layers[static_cast<size_t>(i)];
-        DrawLayerGarland(i, layer.y0, layer.y1, layer.halfW);
-    }
-
-    // star + glow
-    float starY = topY - g_state.height * 0.03f;
-    float outer = g_state.width * 0.040f;
-    float inner = g_state.width * 0.019f;
-    Color glow = AdjustColor(FromRGB(255, 220, 70), 25);
-    glow.a = 0.40f;
-    DrawStar(cx, starY, outer + 6.0f, inner + 3.0f, glow);
-
-    Color star = FromRGB(255, 215, 60);
-    DrawStar(cx, starY, outer, inner, star);
-}
-
-static void DrawOrnaments() {
-    for (const auto& o : g_state.ornaments) {
-        Color c = o.on ? o.colorA : o.colorB;
-        float glowR = o.radius + (o.on ? 3.0f : 1.0f);
-        Color glow = AdjustColor(c, 40);
-        glow.a = o.on ? 0.40f : 0.22f;
-        DrawCircle(o.x, o.y, glowR, glow);
-
-        DrawCircle(o.x, o.y, o.radius, c);
-
-        if (o.radius >= 5.0f) {
-            float innerR = o.radius - 2.0f;
-            Color inner = AdjustColor(c, 25);
-            inner.a = 0.9f;
-            DrawCircle(o.x, o.y, innerR, inner);
-        }
-
-        Color shine = FromRGB(255, 255, 255, 0.9f);
-        DrawCircle(o.x - o.radius / 3.0f, o.y - o.radius / 3.0f, 1.5f, shine, 10);
-    }
-}
-
-static void DrawSnow() {
-    for (const auto& s : g_state.snowflakes) {
-        Color c = (s.radius >= 3.0f) ? FromRGB(230, 240, 255) : FromRGB(255, 255, 255);
-        c.a = 0.95f;
-        DrawCircle(s.x, s.y, s.radius, c, 14);
-    }
-}
-
-static void UpdateAnimationStep() {
-    g_state.blinkPhase = (g_state.blinkPhase + 1) % 60;
-    if (g_state.blinkPhase % 10 == 0) {
-        for (auto& o : g_state.ornaments) {
-            if (RandInt(g_state.rng, 0, 2) == 0) {
-                o.on = !o.on;
-            }
-        }
-    }
-
-    for (auto& s : g_state.snowflakes) {
-        s.y += s.speed;
-        s.x += s.drift;
-        if (s.y > g_state.height + 10) {
-            s.y = RandFloat(g_state.rng, -30.0f, -5.0f);
-            s.x = RandFloat(g_state.rng, 0.0f, static_cast<float>(g_state.width));
-            s.speed = RandFloat(g_state.rng, 0.5f, 1.8f);
-            s.drift = RandFloat(g_state.rng, -0.3f, 0.3f);
-            s.radius = static_cast<float>(RandInt(g_state.rng, 1, 3));
-        }
-        if (s.x < -10) s.x = static_cast<float>(g_state.width + 5);
-        if (s.x > g_state.width + 10) s.x = -5.0f;
-    }
+// Live resizing delivers a burst of size events; SimThread coalesces them
+// (see SimThread::Post).
+static void FramebufferSizeCallback(GLFWwindow*, int w, int h) {
+    g_sim.Post({SimCommand::Type::Resize, w, h});
 }
 
-static void FramebufferSizeCallback(GLFWwindow*, int w, int h) {
-    RegenerateScene(w, h);
+static void WindowRefreshCallback(GLFWwindow*) {
+    g_scheduler.RequestRedraw();
 }
 
 static void KeyCallback(GLFWwindow* window, int key, int, int action, int) {
@@ -877,10 +477,30 @@ static void KeyCallback(GLFWwindow* window, int key, int, int action, int) {
         return;
     }
 
+    if (key == GLFW_KEY_H) {
+        g_profiler.SetHudVisible(!g_profiler.HudVisible());
+        g_scheduler.RequestRedraw();
+        return;
+    }
+
+    if (key == GLFW_KEY_G) {
+        g_gpuProfiler.SetEnabled(!g_gpuProfiler.Enabled());
+        return;
+    }
+
+    if (key == GLFW_KEY_S) {
+        if (g_options.saveScenePath) {
+            g_sim.Post({SimCommand::Type::Save, 0, 0, g_options.saveScenePath});
+        } else {
+            std::fprintf(stderr, "scene: pass --save-scene=FILE to save with S\n");
+        }
+        return;
+    }
+
     if (key == GLFW_KEY_R) {
         int w, h;
         glfwGetFramebufferSize(window, &w, &h);
-        RegenerateScene(w, h);
+        g_sim.Post({SimCommand::Type::Regenerate, w, h});
         return;
     }
 }
@@ -945,44 +565,362 @@ static void PositionBottomRight(GLFWwindow* window, int winW, int winH) {
     glfwSetWindowPos(window, x, y);
 }
 
-int main() {
-    if (!glfwInit()) {
-        return 1;
+// Below 5 Hz a tick would span a whole ornament blink period.
+static constexpr int kMinSimHz = 5;
+static constexpr int kMaxSimHz = 60;
+
+static int ClampInt(int v, int lo, int hi) {
+    return std::max(lo, std::min(hi, v));
+}
+
+static void ParseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--gl=core") == 0) {
+            g_options.backend = RenderBackend::Core;
+        } else if (std::strcmp(arg, "--gl=legacy") == 0) {
+            g_options.backend = RenderBackend::Legacy;
+        } else if (std::strcmp(arg, "--gl=software") == 0) {
+            g_options.backend = RenderBackend::Software;
+        } else if (std::strcmp(arg, "--gl=auto") == 0) {
+            g_options.backend = RenderBackend::Auto;
+        } else if (std::strcmp(arg, "--stats") == 0) {
+            g_options.stats = true;
+        } else if (std::strncmp(arg, "--seed=", 7) == 0) {
+            g_options.seeded = true;
+            g_options.seed = std::strtoull(arg + 7, nullptr, 10);
+        } else if (std::strcmp(arg, "--gpu-snow") == 0) {
+            g_sceneOptions.gpuSnow = true;
+        } else if (std::strncmp(arg, "--snow=", 7) == 0) {
+            g_sceneOptions.snowBudget = std::max(0, std::atoi(arg + 7));
+        } else if (std::strncmp(arg, "--needles=", 10) == 0) {
+            g_sceneOptions.needleBudget = std::max(0, std::atoi(arg + 10));
+        } else if (std::strncmp(arg, "--headless=", 11) == 0) {
+            if (std::sscanf(arg + 11, "%dx%d", &g_options.headlessWidth, &g_options.headlessHeight) != 2 ||
+                g_options.headlessWidth <= 0 || g_options.headlessHeight <= 0) {
+                g_options.headlessWidth = 0;
+                g_options.headlessHeight = 0;
+            }
+        } else if (std::strncmp(arg, "--frames=", 9) == 0) {
+            g_options.frames = std::max(1, std::atoi(arg + 9));
+        } else if (std::strncmp(arg, "--dump=", 7) == 0) {
+            g_options.dumpPrefix = arg + 7;
+        } else if (std::strcmp(arg, "--gpu-profile") == 0) {
+            g_options.gpuProfile = true;
+        } else if (std::strcmp(arg, "--hud") == 0) {
+            g_options.hud = true;
+        } else if (std::strncmp(arg, "--trace=", 8) == 0) {
+            g_options.tracePath = arg + 8;
+        } else if (std::strncmp(arg, "--trace-frames=", 15) == 0) {
+            g_options.traceFrames = std::max(1, std::atoi(arg + 15));
+        } else if (std::strncmp(arg, "--threads=", 10) == 0) {
+            g_options.threads = std::max(0, std::atoi(arg + 10));
+        } else if (std::strncmp(arg, "--sim-hz=", 9) == 0) {
+            g_options.simHz = ClampInt(std::atoi(arg + 9), kMinSimHz, kMaxSimHz);
+        } else if (std::strcmp(arg, "--interpolate") == 0) {
+            g_sceneOptions.interpolate = true;
+        } else if (std::strcmp(arg, "--aa=sdf") == 0) {
+            g_sceneOptions.sdfAntialias = true;
+        } else if (std::strcmp(arg, "--aa=msaa") == 0) {
+            g_sceneOptions.sdfAntialias = false;
+        } else if (std::strncmp(arg, "--scene=", 8) == 0) {
+            g_options.scenePath = arg + 8;
+        } else if (std::strncmp(arg, "--save-scene=", 13) == 0) {
+            g_options.saveScenePath = arg + 13;
+        } else if (std::strcmp(arg, "--startup-report") == 0) {
+            g_options.startupReport = true;
+        }
     }
+}
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4);
+// --aa=sdf only applies to the core backend; legacy keeps 4x MSAA.
+static int AntialiasSamples(bool core) {
+    return core && g_sceneOptions.sdfAntialias ? 0 : 4;
+}
+
+static GLFWwindow* CreateOverlayWindow(int w, int h, RenderBackend backend) {
+    glfwDefaultWindowHints();
+    if (backend == RenderBackend::Software) {
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    } else if (backend == RenderBackend::Core) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+#endif
+    } else {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
+    }
+    glfwWindowHint(GLFW_SAMPLES, AntialiasSamples(backend == RenderBackend::Core));
     glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
     glfwWindowHint(GLFW_FLOATING, GLFW_TRUE);
     glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, GLFW_TRUE);
     glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    return glfwCreateWindow(w, h, "Xmass Tree", nullptr, nullptr);
+}
+
+// The starting scene: the --scene file when it loads, a generated one
+// otherwise. It is fitted to the window and written to --save-scene.
+static void CreateInitialScene(int w, int h) {
+    if (g_options.scenePath && LoadScene(g_options.scenePath)) {
+        ResizeScene(w, h);
+    } else {
+        RegenerateScene(w, h);
+    }
+    if (g_options.saveScenePath) {
+        SaveScene(g_options.saveScenePath);
+    }
+}
+
+static double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+// --headless=WxH: renders --frames frames into an EGL pbuffer with no
+// window, one animation tick per frame simulated inline (so a seed always
+// gives the same frames), and prints per-frame update and
+// render times (the render time includes glFinish). With --dump=PREFIX
+// each frame is also written to PREFIX00000.rgba as raw top-down RGBA8.
+static int RunHeadless() {
+    const int w = g_options.headlessWidth;
+    const int h = g_options.headlessHeight;
+
+    std::vector<bool> attempts;
+    if (g_options.backend != RenderBackend::Legacy) attempts.push_back(true);
+    if (g_options.backend != RenderBackend::Core) attempts.push_back(false);
+
+    const bool software = g_options.backend == RenderBackend::Software;
+    if (software) attempts.clear();
+
+    HeadlessContext context;
+    bool ready = software;
+    bool core = false;
+    for (bool tryCore : attempts) {
+        const bool created = context.Create(w, h, tryCore, AntialiasSamples(tryCore));
+        g_startup.Mark("context");
+        if (!created) continue;
+        const bool initialized = InitRenderer(HeadlessContext::Loader(), tryCore);
+        g_startup.Mark("renderer");
+        if (initialized) {
+            ready = true;
+            core = tryCore;
+            break;
+        }
+        context.Destroy();
+    }
+    if (!ready) {
+        std::fprintf(stderr, "headless: no usable OpenGL context\n");
+        return 1;
+    }
+
+    ResolveGpuSnow();
+    CreateInitialScene(w, h);
+    PublishSnapshot(0.0);
+    AcquireSnapshot();
+    g_startup.Mark("scene");
+
+    std::printf("headless: %dx%d %s, %d frames, seed %llu\n", w, h, software ? "software" : (core ? "core" : "legacy"), g_options.frames,
+                static_cast<unsigned long long>(g_options.seed));
+    std::printf("frame,update_ms,render_ms\n");
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> updateMs;
+    std::vector<double> renderMs;
+    updateMs.reserve(static_cast<size_t>(g_options.frames));
+    renderMs.reserve(static_cast<size_t>(g_options.frames));
+    std::vector<unsigned char> pixels;
+    if (g_options.dumpPrefix) {
+        pixels.resize(static_cast<size_t>(w) * h * 4);
+    }
+
+    for (int frame = 0; frame < g_options.frames; ++frame) {
+        Clock::time_point t0 = Clock::now();
+        UpdateAnimationStep();
+        PublishSnapshot(0.0);
+        AcquireSnapshot();
+        Clock::time_point t1 = Clock::now();
+        if (software) {
+            RenderFrameSoftware(w, h, 1.0f);
+        } else {
+            RenderFrame(w, h, 1.0f);
+            XMASS_PROFILE_SCOPE("Finish");
+            glFinish();
+        }
+        Clock::time_point t2 = Clock::now();
+        g_profiler.FrameBoundary();
+        if (frame == 0 && g_options.startupReport) {
+            g_startup.Mark("first_frame");
+            g_startup.Report(stdout);
+        }
+
+        updateMs.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        renderMs.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+        std::printf("%d,%.3f,%.3f\n", frame, updateMs.back(), renderMs.back());
+
+        if (g_options.dumpPrefix) {
+            if (software) {
+                std::memcpy(pixels.data(), SoftwareFrame().Pixels(), pixels.size());
+            } else {
+                context.ReadRGBA(pixels.data());
+            }
+            char path[1024];
+            std::snprintf(path, sizeof(path), "%s%05d.rgba", g_options.dumpPrefix, frame);
+            if (FILE* f = std::fopen(path, "wb")) {
+                std::fwrite(pixels.data(), 1, pixels.size(), f);
+                std::fclose(f);
+            } else {
+                std::fprintf(stderr, "headless: cannot write %s\n", path);
+            }
+        }
+    }
+
+    std::printf("update_ms: median=%.3f p99=%.3f max=%.3f\n", Percentile(updateMs, 0.5), Percentile(updateMs, 0.99),
+                Percentile(updateMs, 1.0));
+    std::printf("render_ms: median=%.3f p99=%.3f max=%.3f\n", Percentile(renderMs, 0.5), Percentile(renderMs, 0.99),
+                Percentile(renderMs, 1.0));
+
+    if (g_options.stats) {
+        std::printf("scene: %zu ornaments, %zu needles, %zu bytes\n", g_state.ornaments.size(), g_state.needles.size(), SceneMemoryBytes());
+    }
+    if (g_options.stats || g_options.gpuProfile) {
+        if (g_options.gpuProfile && !g_gpuProfiler.Ready()) {
+            std::printf("profile: no GPU timer queries on this backend\n");
+        }
+        g_profiler.Report(stdout);
+    }
+
+    if (!software) {
+        ShutdownRenderer();
+    }
+    context.Destroy();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    g_startup.Start();
+    ParseOptions(argc, argv);
+    if (!g_options.seeded) {
+        std::random_device device;
+        g_options.seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+    }
+    g_state.rng.Seed(g_options.seed);
+    g_sceneOptions.simStep = 30.0f / static_cast<float>(g_options.simHz);
+    g_scheduler.SetTickInterval(1.0 / g_options.simHz);
+    g_scheduler.SetContinuous(g_sceneOptions.interpolate);
+    g_profiler.SetHudVisible(g_options.hud);
+    g_gpuProfiler.SetEnabled(g_options.gpuProfile);
+    if (g_options.tracePath) {
+        g_profiler.StartTrace(g_options.tracePath, g_options.traceFrames);
+    }
+#ifndef XMASS_PROFILER
+    if (g_options.hud || g_options.tracePath) {
+        std::fprintf(stderr, "profiler: built with XMASS_PROFILER=OFF, no stages will be recorded\n");
+    }
+#endif
+    const bool software = g_options.backend == RenderBackend::Software;
+    const bool parallelSnow = static_cast<size_t>(g_sceneOptions.snowBudget) >= 2 * kSnowChunk;
+    if (software) {
+        g_pool.Start(g_options.threads);
+    }
+    if (parallelSnow) {
+        g_simPool.Start(g_options.threads);
+    }
+
+    g_startup.Mark("options");
 
+    if (g_options.headlessWidth > 0) {
+        int result = RunHeadless();
+        g_profiler.FinishTrace();
+        g_pool.Stop();
+        g_simPool.Stop();
+        return result;
+    }
+
+    // The starting scene needs nothing but a size, so it is built on a
+    // background thread while GLFW, the window and the renderer come up,
+    // which mostly wait on the display server and the driver. It is fitted
+    // to the framebuffer afterwards if content scaling made that larger.
     const int initialW = 420;
     const int initialH = 520;
-    GLFWwindow* window = glfwCreateWindow(initialW, initialH, "Xmass Tree", nullptr, nullptr);
+    double sceneJobMs = 0.0;
+    std::thread sceneJob([&] {
+        const auto t0 = std::chrono::steady_clock::now();
+        CreateInitialScene(initialW, initialH);
+        sceneJobMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    });
+
+    if (!glfwInit()) {
+        sceneJob.join();
+        g_pool.Stop();
+        g_simPool.Stop();
+        return 1;
+    }
+    g_startup.Mark("glfwInit");
+
+    std::vector<RenderBackend> attempts;
+    if (software) {
+        attempts.push_back(RenderBackend::Software);
+    } else {
+        if (g_options.backend != RenderBackend::Legacy) attempts.push_back(RenderBackend::Core);
+        if (g_options.backend != RenderBackend::Core) attempts.push_back(RenderBackend::Legacy);
+    }
+
+    GLFWwindow* window = nullptr;
+    for (RenderBackend backend : attempts) {
+        window = CreateOverlayWindow(initialW, initialH, backend);
+        g_startup.Mark("window");
+        if (!window) continue;
+        if (backend == RenderBackend::Software) {
+            const bool attached = g_presenter.Attach(window);
+            g_startup.Mark("renderer");
+            if (attached) break;
+            std::fprintf(stderr, "software renderer: no X11 window to present to; use --headless\n");
+        } else {
+            glfwMakeContextCurrent(window);
+            g_startup.Mark("context");
+            const bool initialized = InitRenderer(glfwGetProcAddress, backend == RenderBackend::Core);
+            g_startup.Mark("renderer");
+            if (initialized) break;
+            glfwMakeContextCurrent(nullptr);
+        }
+        glfwDestroyWindow(window);
+        window = nullptr;
+    }
+    sceneJob.join();
+    g_startup.Mark("scene_wait");
+    g_startup.Background("scene", sceneJobMs);
     if (!window) {
+        g_pool.Stop();
+        g_simPool.Stop();
         glfwTerminate();
         return 1;
     }
 
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
-
-    glEnable(GL_MULTISAMPLE);
-    glEnable(GL_LINE_SMOOTH);
-    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+    if (software) {
+        SoftwareFrame().SetBgraOutput(g_presenter.WantsBgra());
+    } else {
+        glfwSwapInterval(1);
+    }
 
     glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
     glfwSetKeyCallback(window, KeyCallback);
     glfwSetMouseButtonCallback(window, MouseButtonCallback);
     glfwSetCursorPosCallback(window, CursorPosCallback);
     glfwSetWindowCloseCallback(window, WindowCloseCallback);
+    glfwSetWindowRefreshCallback(window, WindowRefreshCallback);
 
+    ResolveGpuSnow();
     int fbW, fbH;
     glfwGetFramebufferSize(window, &fbW, &fbH);
-    RegenerateScene(fbW, fbH);
+    ResizeScene(fbW, fbH);
+    PublishSnapshot(SimThread::Now());
+    g_startup.Mark("scene");
     PositionBottomRight(window, initialW, initialH);
 
     SetClickThrough(window, false);
@@ -992,50 +930,115 @@ int main() {
     InitTray(window);
 #endif
 
-    double lastTime = glfwGetTime();
-    double accumulator = 0.0;
-    const double step = 1.0 / 30.0;
+    const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    const int refreshRate = (mode && mode->refreshRate > 0) ? mode->refreshRate : 60;
+
+    if (g_options.stats) {
+        if (GpuSnowActive()) {
+            std::printf("snow: %zu flakes, animated in the vertex shader\n", GpuSnowCount());
+        } else {
+            std::printf("snow: %zu flakes, %s kernel, %d worker(s)\n", g_state.snow.Size(), SnowKernelName(), g_state.snow.Size() >= 2 * kSnowChunk ? g_simPool.WorkerCount() : 1);
+        }
+        std::printf("scene: %zu ornaments, %zu needles, %zu bytes\n", g_state.ornaments.size(), g_state.needles.size(), SceneMemoryBytes());
+    }
+
+    // From here on g_state belongs to the simulation thread.
+    g_sim.Start(g_scheduler.TickInterval(), [] { glfwPostEmptyEvent(); });
+    g_scheduler.Start(glfwGetTime());
+    g_power.Attach(window);
+    double nextReport = glfwGetTime() + 5.0;
+    bool wasRendering = true;
+    bool firstFrame = g_options.startupReport;
+    g_startup.Mark("setup");
 
     while (!glfwWindowShouldClose(window)) {
-        bool visible = glfwGetWindowAttrib(window, GLFW_VISIBLE) == GLFW_TRUE;
-        if (!visible) {
-            glfwWaitEventsTimeout(0.25);
+        double now = glfwGetTime();
+        const PowerProfile& profile = PowerProfileFor(g_power.Update(now));
+
+        if (g_options.stats && now >= nextReport) {
+            g_scheduler.Report(stdout, now, refreshRate);
+            g_sim.Report(stdout);
+            g_power.Report(stdout);
+            g_profiler.Report(stdout);
+            nextReport = now + 5.0;
+        }
+
+        if (!profile.renders) {
+            // Nobody can see the overlay: freeze the animation and sleep
+            // until an event, or until the next state re-check.
+            if (wasRendering) g_sim.SetPaused(true);
+            if (profile.pollInterval < 0.0) {
+                glfwWaitEvents();
+            } else {
+                glfwWaitEventsTimeout(profile.pollInterval);
+            }
+            g_power.CountWakeup();
+            wasRendering = false;
+            continue;
+        }
+
+        if (!wasRendering) {
+            g_sim.SetPaused(false);
+            g_scheduler.Resume();
+            wasRendering = true;
+        }
+        // Interpolated frames are capped at the display rate: without that
+        // a driver that does not block in SwapBuffers would spin.
+        g_scheduler.SetFrameInterval(g_sceneOptions.interpolate ? std::max(profile.frameInterval, 1.0 / refreshRate) : profile.frameInterval);
+
+        double timeout = g_scheduler.WaitTimeout(now);
+        if (timeout > 0.0) {
+            glfwWaitEventsTimeout(timeout);
         } else {
             glfwPollEvents();
         }
+        g_power.CountWakeup();
 
-        double now = glfwGetTime();
-        double dt = now - lastTime;
-        lastTime = now;
-        accumulator += dt;
-        while (accumulator >= step) {
-            UpdateAnimationStep();
-            accumulator -= step;
+        now = glfwGetTime();
+        if (AcquireSnapshot()) {
+            g_scheduler.SnapshotArrived();
         }
 
-        if (visible) {
-            int w, h;
-            glfwGetFramebufferSize(window, &w, &h);
-            glViewport(0, 0, w, h);
-            glMatrixMode(GL_PROJECTION);
-            glLoadIdentity();
-            glOrtho(0, w, h, 0, -1, 1);
-            glMatrixMode(GL_MODELVIEW);
-            glLoadIdentity();
-
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-
-            DrawTree();
-            DrawOrnaments();
-            DrawSnow();
-
-            glfwSwapBuffers(window);
+        if (g_scheduler.ShouldRender(now)) {
+            int fbW, fbH;
+            glfwGetFramebufferSize(window, &fbW, &fbH);
+            // Interpolated frames trail the simulation by one tick: the blend
+            // runs from the previous state at the newest snapshot's tick
+            // time to the current one a tick later, when the next arrives.
+            float blend = 1.0f;
+            if (g_sceneOptions.interpolate) {
+                const double since = SimThread::Now() - SnapshotTime();
+                blend = static_cast<float>(std::min(1.0, std::max(0.0, since / g_scheduler.TickInterval())));
+            }
+            if (software) {
+                RenderFrameSoftware(fbW, fbH, blend);
+                if (firstFrame) g_startup.Mark("first_frame");
+                XMASS_PROFILE_SCOPE("Present");
+                g_presenter.Present(SoftwareFrame().Pixels(), fbW, fbH);
+            } else {
+                RenderFrame(fbW, fbH, blend);
+                if (firstFrame) g_startup.Mark("first_frame");
+                XMASS_PROFILE_SCOPE("SwapBuffers");
+                glfwSwapBuffers(window);
+            }
+            if (firstFrame) {
+                g_startup.Mark("first_swap");
+                g_startup.Report(stdout);
+                firstFrame = false;
+            }
+            g_profiler.FrameBoundary();
+            g_power.CountRender();
         }
     }
 
+    g_sim.Stop();
+    if (g_options.stats) {
+        g_scheduler.Report(stdout, glfwGetTime(), refreshRate);
+        g_sim.Report(stdout);
+        g_power.Report(stdout);
+        g_profiler.Report(stdout);
+    }
+
 #ifdef _WIN32
     DeleteTrayIcon();
     if (g_trayHwnd) {
@@ -1044,6 +1047,14 @@ int main() {
     }
 #endif
 
+    g_profiler.FinishTrace();
+    if (software) {
+        g_presenter.Detach();
+    } else {
+        ShutdownRenderer();
+    }
+    g_pool.Stop();
+    g_simPool.Stop();
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
@@ -1051,6 +1062,21 @@ int main() {
 
 #ifdef _WIN32
 int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
-    return main();
+    int argc = 0;
+    LPWSTR* wargv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    std::vector<std::string> args;
+    for (int i = 0; i < argc; ++i) {
+        int len = WideCharToMultiByte(CP_UTF8, 0, wargv[i], -1, nullptr, 0, nullptr, nullptr);
+        std::string arg(static_cast<size_t>(std::max(len, 1)), '\0');
+        WideCharToMultiByte(CP_UTF8, 0, wargv[i], -1, &arg[0], len, nullptr, nullptr);
+        arg.resize(std::strlen(arg.c_str()));
+        args.push_back(arg);
+    }
+    if (wargv) LocalFree(wargv);
+
+    std::vector<char*> argv;
+    for (auto& arg : args) argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+    return main(argc, argv.data());
 }
 #endif
@@ -1,12 +1,20 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
-#include <iostream>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <random>
-#include <string>
 #include <thread>
 #include <vector>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 struct Light {
     int row = 0;
     int col = 0; // offset in [-row, row]
@@ -15,51 +23,131 @@ struct Light {
     bool on = true;
 };
 
-static void ClearScreen() {
-    std::cout << "\x1b[2J\x1b[H";
-}
+// One character cell: a glyph and its SGR foreground color (0 = default),
+// optionally dim.
+struct Cell {
+    char glyph = ' ';
+    uint8_t color = 0;
+    bool dim = false;
+
+    bool operator==(const Cell& o) const { return glyph == o.glyph && color == o.color && dim == o.dim; }
+};
 
-static std::string Ansi(int code) {
-    return "\x1b[" + std::to_string(code) + "m";
+static volatile std::sig_atomic_t g_quit = 0;
+
+static void OnInterrupt(int) {
+    g_quit = 1;
 }
 
-static void RenderTree(int height, const std::vector<Light>& lights, const std::vector<std::vector<size_t>>& lightsByRow) {
-    const std::string reset = Ansi(0);
-    const std::string green = Ansi(32);
-    const std::string brightGreen = Ansi(92);
-    const std::string yellow = Ansi(33);
-    const std::string brown = Ansi(33) + Ansi(2);
+static void WriteAll(const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        const int n = _write(1, data, static_cast<unsigned>(size));
+#else
+        const ssize_t n = write(STDOUT_FILENO, data, size);
+#endif
+        if (n <= 0) return;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
 
-    std::cout << std::string(height, ' ') << yellow << "*" << reset << "\n";
+// Draws into a grid of cells and sends the terminal only the cells that
+// changed since the last Present, positioned with cursor escapes. A frame
+// is assembled in one buffer sized for the worst case up front and goes out
+// in one write(), so nothing is allocated per frame and a remote terminal
+// never shows half a frame.
+class CellRenderer {
+public:
+    CellRenderer(int width, int height)
+        : width_(width), height_(height), cells_(static_cast<size_t>(width * height)),
+          // Nothing matches a zero glyph, so the first Present draws every
+          // cell.
+          shown_(static_cast<size_t>(width * height), Cell{'\0', 0, false}),
+          // Worst case per cell: a cursor move, a color change and the glyph.
+          out_(static_cast<size_t>(width * height) * (kMaxMoveBytes + kMaxColorBytes + 1) + 64) {}
+
+    void Clear() { std::fill(cells_.begin(), cells_.end(), Cell{}); }
+
+    void Put(int x, int y, char glyph, uint8_t color, bool dim = false) {
+        if (x < 0 || y < 0 || x >= width_ || y >= height_) return;
+        cells_[static_cast<size_t>(y * width_ + x)] = {glyph, color, dim};
+    }
 
-    for (int row = 0; row < height; ++row) {
-        int indent = height - row;
-        std::cout << std::string(indent, ' ');
+    void Text(int x, int y, const char* text, uint8_t color = 0) {
+        for (; *text; ++text, ++x) Put(x, y, *text, color);
+    }
 
-        for (int col = -row; col <= row; ++col) {
-            const Light* light = nullptr;
-            for (size_t idx : lightsByRow[row]) {
-                if (lights[idx].col == col) {
-                    light = &lights[idx];
-                    break;
+    // Writes the changes and returns how many bytes that took.
+    size_t Present() {
+        char* p = out_.data();
+        int cursorX = -1; // where the terminal's cursor and color are, if known
+        int cursorY = -1;
+        int penColor = -1;
+        bool penDim = false;
+        for (int y = 0; y < height_; ++y) {
+            for (int x = 0; x < width_; ++x) {
+                const size_t i = static_cast<size_t>(y * width_ + x);
+                const Cell& c = cells_[i];
+                if (c == shown_[i]) continue;
+                if (x != cursorX || y != cursorY) {
+                    p += std::sprintf(p, "\x1b[%d;%dH", y + 1, x + 1);
+                }
+                if (c.color != penColor || c.dim != penDim) {
+                    p += std::sprintf(p, c.dim ? "\x1b[0;%d;2m" : "\x1b[0;%dm", c.color);
+                    penColor = c.color;
+                    penDim = c.dim;
                 }
+                *p++ = c.glyph;
+                cursorX = x + 1;
+                cursorY = y;
+                shown_[i] = c;
             }
+        }
+        if (penColor > 0 || penDim) {
+            std::memcpy(p, "\x1b[0m", 4);
+            p += 4;
+        }
+        const size_t bytes = static_cast<size_t>(p - out_.data());
+        WriteAll(out_.data(), bytes);
+        return bytes;
+    }
+
+private:
+    static constexpr int kMaxMoveBytes = 12;  // "\x1b[9999;9999H"
+    static constexpr int kMaxColorBytes = 11; // "\x1b[0;255;2m"
+
+    int width_;
+    int height_;
+    std::vector<Cell> cells_;
+    std::vector<Cell> shown_; // what the terminal shows
+    std::vector<char> out_;
+};
+
+static void DrawTree(CellRenderer& screen, int top, int height, const std::vector<Light>& lights, const std::vector<int16_t>& lightAt) {
+    const int width = 2 * height + 1;
+    screen.Put(height, top, '*', 33);
 
-            if (light) {
-                int c = light->on ? light->colorA : light->colorB;
-                std::cout << Ansi(c) << "o" << reset;
+    for (int row = 0; row < height; ++row) {
+        const int y = top + 1 + row;
+        for (int col = -row; col <= row; ++col) {
+            const int light = lightAt[static_cast<size_t>(row * width + col + height)];
+            if (light >= 0) {
+                const Light& l = lights[static_cast<size_t>(light)];
+                screen.Put(height + col, y, 'o', static_cast<uint8_t>(l.on ? l.colorA : l.colorB));
             } else {
-                std::cout << ((row % 2 == 0) ? brightGreen : green) << "^" << reset;
+                screen.Put(height + col, y, '^', (row % 2 == 0) ? 92 : 32);
             }
         }
-        std::cout << "\n";
     }
 
     int trunkHeight = std::max(3, height / 5);
     int trunkWidth = 3;
     int indent = height - 1;
     for (int i = 0; i < trunkHeight; ++i) {
-        std::cout << std::string(indent, ' ') << brown << std::string(trunkWidth, '#') << reset << "\n";
+        for (int x = 0; x < trunkWidth; ++x) {
+            screen.Put(indent + x, top + 1 + height + i, '#', 33, true);
+        }
     }
 }
 
@@ -88,15 +176,32 @@ int main() {
         lights.push_back(l);
     }
 
-    std::vector<std::vector<size_t>> lightsByRow(height);
+    // Which light, if any, sits in each cell of the tree's bounding box.
+    // Two can land on the same cell; the first one is shown.
+    const int treeWidth = 2 * height + 1;
+    std::vector<int16_t> lightAt(static_cast<size_t>(height * treeWidth), -1);
     for (size_t i = 0; i < lights.size(); ++i) {
         if (lights[i].row >= 0 && lights[i].row < height) {
-            lightsByRow[lights[i].row].push_back(i);
+            int16_t& cell = lightAt[static_cast<size_t>(lights[i].row * treeWidth + lights[i].col + height)];
+            if (cell < 0) cell = static_cast<int16_t>(i);
         }
     }
 
+    const int trunkHeight = std::max(3, height / 5);
+    const int treeTop = 2;
+    const int statusRow = treeTop + 1 + height + trunkHeight + 1;
+    CellRenderer screen(std::max(treeWidth + 1, 64), statusRow + 1);
+
+    std::signal(SIGINT, OnInterrupt);
+    const char kEnter[] = "\x1b[2J\x1b[?25l";
+    WriteAll(kEnter, sizeof(kEnter) - 1);
+
     int phase = 0;
-    while (true) {
+    size_t firstBytes = 0;
+    size_t lastBytes = 0;
+    size_t totalBytes = 0;
+    char status[64];
+    while (!g_quit) {
         if (phase % 5 == 0) {
             for (auto& l : lights) {
                 if (toggleDist(rng) == 0) {
@@ -105,11 +210,22 @@ int main() {
             }
         }
 
-        ClearScreen();
-        std::cout << "Xmass Tree (console edition) - Ctrl+C to exit\n\n";
-        RenderTree(height, lights, lightsByRow);
+        screen.Clear();
+        screen.Text(0, 0, "Xmass Tree (console edition) - Ctrl+C to exit");
+        DrawTree(screen, treeTop, height, lights, lightAt);
+        std::snprintf(status, sizeof(status), "%zu bytes last frame", lastBytes);
+        screen.Text(0, statusRow, status, 90);
+        lastBytes = screen.Present();
+        if (phase == 0) firstBytes = lastBytes;
+        totalBytes += lastBytes;
 
         std::this_thread::sleep_for(std::chrono::milliseconds(120));
         ++phase;
     }
+
+    char summary[160];
+    const int n = std::snprintf(summary, sizeof(summary), "\x1b[0m\x1b[?25h\x1b[%d;1H\nconsole: %d frames, first %zu bytes, then %.1f bytes/frame\n",
+                                statusRow + 1, phase, firstBytes, phase > 1 ? static_cast<double>(totalBytes - firstBytes) / (phase - 1) : 0.0);
+    WriteAll(summary, static_cast<size_t>(std::max(0, n)));
+    return 0;
 }
@@ -0,0 +1,129 @@
+#include "needle_renderer.h"
+
+#include "scene.h"
+
+#include <cstddef>
+#include <cstdint>
+
+static const char* kNeedleVertexShader = R"(#version 330 core
+uniform vec2 uViewport;
+uniform vec2 uScene;
+uniform float uPad;
+in vec2 aCorner;
+in vec2 aStart;
+in vec2 aOffset;
+in vec4 aColor;
+out vec4 vColor;
+out vec2 vLocal;
+flat out float vLength;
+void main() {
+    vec2 d = aOffset / 16.0;
+    float len = length(d);
+    vec2 dir = len > 0.0 ? d / len : vec2(0.0);
+    // Along the needle and across it, half a pixel either side, plus the
+    // SDF ramp's margin on every edge.
+    vLocal = vec2(mix(-uPad, len + uPad, aCorner.x), aCorner.y * (0.5 + uPad));
+    vLength = len;
+    vec2 p = aStart * uScene + dir * vLocal.x + vec2(-dir.y, dir.x) * vLocal.y;
+    vec2 ndc = p / uViewport * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    vColor = aColor;
+}
+)";
+
+static const char* kNeedleFragmentShader = R"(#version 330 core
+in vec4 vColor;
+out vec4 fragColor;
+void main() {
+    fragColor = vColor;
+}
+)";
+
+// The box distance of SdfRenderer's segments, in the needle's own frame.
+static const char* kNeedleSdfFragmentShader = R"(#version 330 core
+in vec4 vColor;
+in vec2 vLocal;
+flat in float vLength;
+out vec4 fragColor;
+void main() {
+    vec2 q = vec2(abs(vLocal.x - 0.5 * vLength) - 0.5 * vLength, abs(vLocal.y) - 0.5);
+    float d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);
+    float coverage = clamp(0.5 - d, 0.0, 1.0);
+    if (coverage <= 0.0) discard;
+    fragColor = vec4(vColor.rgb, vColor.a * coverage);
+}
+)";
+
+bool NeedleRenderer::Init(bool sdf) {
+    const char* attributes[] = {"aCorner", "aStart", "aOffset", "aColor"};
+    program_ = BuildProgram(kNeedleVertexShader, sdf ? kNeedleSdfFragmentShader : kNeedleFragmentShader, attributes, 4);
+    if (!program_) {
+        return false;
+    }
+    viewportLoc_ = g_gl.GetUniformLocation(program_, "uViewport");
+    sceneLoc_ = g_gl.GetUniformLocation(program_, "uScene");
+    g_gl.UseProgram(program_);
+    g_gl.Uniform1f(g_gl.GetUniformLocation(program_, "uPad"), sdf ? 1.0f : 0.0f);
+    g_gl.UseProgram(0);
+
+    const float mesh[] = {0.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 1.0f};
+    g_gl.GenVertexArrays(1, &vao_);
+    g_gl.GenBuffers(1, &meshVbo_);
+    g_gl.GenBuffers(1, &instanceVbo_);
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, meshVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, sizeof(mesh), mesh, GL_STATIC_DRAW);
+    g_gl.EnableVertexAttribArray(0);
+    g_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    const GLsizei stride = sizeof(NeedleStroke);
+    g_gl.VertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(NeedleStroke, x)));
+    g_gl.VertexAttribPointer(2, 2, GL_BYTE, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(NeedleStroke, dx)));
+    g_gl.VertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(NeedleStroke, c)));
+    for (GLuint attr = 1; attr <= 3; ++attr) {
+        g_gl.EnableVertexAttribArray(attr);
+        g_gl.VertexAttribDivisor(attr, 1);
+    }
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void NeedleRenderer::Destroy() {
+    if (instanceVbo_) g_gl.DeleteBuffers(1, &instanceVbo_);
+    if (meshVbo_) g_gl.DeleteBuffers(1, &meshVbo_);
+    if (vao_) g_gl.DeleteVertexArrays(1, &vao_);
+    if (program_) g_gl.DeleteProgram(program_);
+    instanceVbo_ = 0;
+    meshVbo_ = 0;
+    vao_ = 0;
+    program_ = 0;
+}
+
+void NeedleRenderer::Draw(const NeedleStroke* needles, size_t n, int width, int height) {
+    if (n == 0 || !program_) {
+        return;
+    }
+
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    if (premultipliedTarget_ && g_gl.BlendFuncSeparate) {
+        g_gl.BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    g_gl.UseProgram(program_);
+    g_gl.Uniform2f(viewportLoc_, static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    g_gl.Uniform2f(sceneLoc_, static_cast<float>(width), static_cast<float>(height));
+    g_gl.BindVertexArray(vao_);
+    // Needles only change with the geometry, and the tree cache is only
+    // redrawn then, so this upload happens once per scene.
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(n * sizeof(NeedleStroke)), needles, GL_STATIC_DRAW);
+    g_gl.DrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, static_cast<GLsizei>(n));
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    g_gl.UseProgram(0);
+}
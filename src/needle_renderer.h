@@ -0,0 +1,37 @@
+#pragma once
+
+#include "gl_ext.h"
+
+#include <cstddef>
+
+struct NeedleStroke;
+
+// Core-profile only. Draws needles straight from the scene's NeedleStroke
+// array: the records are uploaded as they are and bound as per-instance
+// attributes (normalized GL_UNSIGNED_SHORT start, GL_BYTE offset in
+// 1/16 px, normalized GL_UNSIGNED_BYTE color), and the vertex shader turns
+// each one into a 1 px wide quad. Nothing is decoded on the CPU.
+//
+// Init(true) pads the quad by a pixel and computes analytic edge coverage,
+// as SdfRenderer::Segment does, for --aa=sdf.
+class NeedleRenderer {
+public:
+    bool Init(bool sdf);
+    void Destroy();
+    bool Ready() const { return program_ != 0; }
+
+    // As BatchRenderer::SetPremultipliedTarget.
+    void SetPremultipliedTarget(bool enabled) { premultipliedTarget_ = enabled; }
+
+    // `width` x `height` is the scene size the positions are fractions of.
+    void Draw(const NeedleStroke* needles, size_t n, int width, int height);
+
+private:
+    bool premultipliedTarget_ = false;
+    GLuint program_ = 0;
+    GLint viewportLoc_ = -1;
+    GLint sceneLoc_ = -1;
+    GLuint vao_ = 0;
+    GLuint meshVbo_ = 0;
+    GLuint instanceVbo_ = 0;
+};
@@ -0,0 +1,248 @@
+#include "ornament_atlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Cells are square, centered on a texel corner and large enough for the
+// biggest glow plus its anti-aliased edge and a gap for linear filtering.
+static constexpr int kCellSize = 32;
+static constexpr int kRadiusCount = kOrnamentMaxRadius - kOrnamentMinRadius + 1;
+
+static const char* kAtlasVertexShader = R"(#version 330 core
+uniform vec2 uViewport;
+uniform vec2 uAtlasSize;
+in vec2 aCorner;
+in vec3 aCenterExtent;
+in vec2 aCell;
+out vec2 vUv;
+void main() {
+    vec2 offset = aCorner * aCenterExtent.z;
+    vec2 p = aCenterExtent.xy + offset;
+    vec2 ndc = p / uViewport * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    vUv = (aCell + offset) / uAtlasSize;
+}
+)";
+
+static const char* kAtlasFragmentShader = R"(#version 330 core
+uniform sampler2D uAtlas;
+in vec2 vUv;
+out vec4 fragColor;
+void main() {
+    vec4 c = texture(uAtlas, vUv);
+    if (c.a == 0.0) discard;
+    fragColor = c;
+}
+)";
+
+int OrnamentLayers(float radius, const Color& c, bool on, OrnamentLayer out[4]) {
+    int n = 0;
+    Color glow = AdjustColor(c, 40);
+    glow.a = on ? 0.40f : 0.22f;
+    out[n++] = {0.0f, 0.0f, radius + (on ? 3.0f : 1.0f), glow};
+    out[n++] = {0.0f, 0.0f, radius, c};
+    if (radius >= 5.0f) {
+        Color inner = AdjustColor(c, 25);
+        inner.a = 0.9f;
+        out[n++] = {0.0f, 0.0f, radius - 2.0f, inner};
+    }
+    out[n++] = {-radius / 3.0f, -radius / 3.0f, 1.5f, FromRGB(255, 255, 255, 0.9f)};
+    return n;
+}
+
+// Half the quad side for a look: the glow radius plus a pixel of edge.
+static int CellExtent(int radius, bool on) {
+    return radius + (on ? 4 : 2);
+}
+
+// Composites the layers back to front with the same one-pixel coverage
+// ramp as the SDF shapes, into premultiplied RGBA.
+static void BakeCell(const OrnamentLayer* layers, int count, uint8_t* pixels, int stride) {
+    for (int y = 0; y < kCellSize; ++y) {
+        for (int x = 0; x < kCellSize; ++x) {
+            const float px = static_cast<float>(x) + 0.5f - kCellSize / 2;
+            const float py = static_cast<float>(y) + 0.5f - kCellSize / 2;
+            float r = 0.0f;
+            float g = 0.0f;
+            float b = 0.0f;
+            float a = 0.0f;
+            for (int i = 0; i < count; ++i) {
+                const OrnamentLayer& l = layers[i];
+                const float dx = px - l.dx;
+                const float dy = py - l.dy;
+                const float d = std::sqrt(dx * dx + dy * dy);
+                const float alpha = std::max(0.0f, std::min(1.0f, l.radius + 0.5f - d)) * l.c.a;
+                r = l.c.r * alpha + r * (1.0f - alpha);
+                g = l.c.g * alpha + g * (1.0f - alpha);
+                b = l.c.b * alpha + b * (1.0f - alpha);
+                a = alpha + a * (1.0f - alpha);
+            }
+            uint8_t* out = pixels + static_cast<size_t>(y) * stride + static_cast<size_t>(x) * 4;
+            out[0] = ToByte(r);
+            out[1] = ToByte(g);
+            out[2] = ToByte(b);
+            out[3] = ToByte(a);
+        }
+    }
+}
+
+bool OrnamentAtlas::Init(const Color* palette, int paletteSize, bool core) {
+    Destroy();
+    if (paletteSize <= 0) return false;
+
+    // Columns are radius × on/off, rows palette colors.
+    width_ = kRadiusCount * 2 * kCellSize;
+    height_ = paletteSize * kCellSize;
+    paletteSize_ = paletteSize;
+    const int stride = width_ * 4;
+    std::vector<uint8_t> pixels(static_cast<size_t>(stride) * height_);
+    OrnamentLayer layers[4];
+    for (int row = 0; row < paletteSize; ++row) {
+        for (int column = 0; column < kRadiusCount * 2; ++column) {
+            const float radius = static_cast<float>(kOrnamentMinRadius + column / 2);
+            const int count = OrnamentLayers(radius, palette[row], (column & 1) != 0, layers);
+            BakeCell(layers, count, pixels.data() + static_cast<size_t>(row) * kCellSize * stride + static_cast<size_t>(column) * kCellSize * 4, stride);
+        }
+    }
+
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (!core) return true;
+
+    const char* attributes[] = {"aCorner", "aCenterExtent", "aCell"};
+    program_ = BuildProgram(kAtlasVertexShader, kAtlasFragmentShader, attributes, 3);
+    if (!program_) {
+        Destroy();
+        return false;
+    }
+    viewportLoc_ = g_gl.GetUniformLocation(program_, "uViewport");
+    atlasSizeLoc_ = g_gl.GetUniformLocation(program_, "uAtlasSize");
+    g_gl.UseProgram(program_);
+    g_gl.Uniform1i(g_gl.GetUniformLocation(program_, "uAtlas"), 0);
+    g_gl.UseProgram(0);
+
+    const GLfloat corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f};
+    g_gl.GenVertexArrays(1, &vao_);
+    g_gl.GenBuffers(1, &meshVbo_);
+    g_gl.GenBuffers(1, &instanceVbo_);
+    g_gl.BindVertexArray(vao_);
+
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, meshVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    g_gl.EnableVertexAttribArray(0);
+    g_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    g_gl.EnableVertexAttribArray(1);
+    g_gl.VertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(OrnamentSprite), reinterpret_cast<const void*>(offsetof(OrnamentSprite, x)));
+    g_gl.VertexAttribDivisor(1, 1);
+    g_gl.EnableVertexAttribArray(2);
+    g_gl.VertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(OrnamentSprite), reinterpret_cast<const void*>(offsetof(OrnamentSprite, u)));
+    g_gl.VertexAttribDivisor(2, 1);
+
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void OrnamentAtlas::Destroy() {
+    if (instanceVbo_) g_gl.DeleteBuffers(1, &instanceVbo_);
+    if (meshVbo_) g_gl.DeleteBuffers(1, &meshVbo_);
+    if (vao_) g_gl.DeleteVertexArrays(1, &vao_);
+    if (program_) g_gl.DeleteProgram(program_);
+    if (texture_) glDeleteTextures(1, &texture_);
+    instanceVbo_ = 0;
+    meshVbo_ = 0;
+    vao_ = 0;
+    program_ = 0;
+    texture_ = 0;
+    width_ = 0;
+    height_ = 0;
+    paletteSize_ = 0;
+}
+
+void OrnamentAtlas::Add(float x, float y, float radius, int paletteIndex, bool on) {
+    const int r = std::max(kOrnamentMinRadius, std::min(kOrnamentMaxRadius, static_cast<int>(radius + 0.5f)));
+    const int row = std::max(0, std::min(paletteSize_ - 1, paletteIndex));
+    const int column = (r - kOrnamentMinRadius) * 2 + (on ? 1 : 0);
+    OrnamentSprite sprite;
+    // Whole-pixel centers copy the cell texel for texel.
+    sprite.x = std::floor(x + 0.5f);
+    sprite.y = std::floor(y + 0.5f);
+    sprite.extent = static_cast<float>(CellExtent(r, on));
+    sprite.u = static_cast<float>(column * kCellSize + kCellSize / 2);
+    sprite.v = static_cast<float>(row * kCellSize + kCellSize / 2);
+    sprites_.push_back(sprite);
+}
+
+void OrnamentAtlas::Flush() {
+    if (sprites_.empty() || !texture_) {
+        sprites_.clear();
+        return;
+    }
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    if (program_) {
+        FlushCore();
+    } else {
+        FlushLegacy();
+    }
+    sprites_.clear();
+}
+
+void OrnamentAtlas::FlushCore() {
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    g_gl.UseProgram(program_);
+    g_gl.Uniform2f(viewportLoc_, static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    g_gl.Uniform2f(atlasSizeLoc_, static_cast<float>(width_), static_cast<float>(height_));
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(sprites_.size() * sizeof(OrnamentSprite)), sprites_.data(), GL_STREAM_DRAW);
+    g_gl.DrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, static_cast<GLsizei>(sprites_.size()));
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    g_gl.UseProgram(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void OrnamentAtlas::FlushLegacy() {
+    static const float kCorners[4][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+    const float invW = 1.0f / static_cast<float>(width_);
+    const float invH = 1.0f / static_cast<float>(height_);
+    legacyVertices_.clear();
+    legacyVertices_.reserve(sprites_.size() * 16);
+    for (const OrnamentSprite& s : sprites_) {
+        // x, y, s, t per corner.
+        for (const auto& corner : kCorners) {
+            const float dx = corner[0] * s.extent;
+            const float dy = corner[1] * s.extent;
+            legacyVertices_.push_back(s.x + dx);
+            legacyVertices_.push_back(s.y + dy);
+            legacyVertices_.push_back((s.u + dx) * invW);
+            legacyVertices_.push_back((s.v + dy) * invH);
+        }
+    }
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 4 * sizeof(float), legacyVertices_.data());
+    glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(float), legacyVertices_.data() + 2);
+    glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(sprites_.size() * 4));
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "color.h"
+#include "gl_ext.h"
+
+#include <vector>
+
+// Ornament radii are whole pixels in this range.
+constexpr int kOrnamentMinRadius = 4;
+constexpr int kOrnamentMaxRadius = 9;
+
+// One of the filled circles an ornament is drawn from, offset from its
+// center.
+struct OrnamentLayer {
+    float dx = 0.0f;
+    float dy = 0.0f;
+    float radius = 0.0f;
+    Color c{};
+};
+
+// The look of an ornament showing color `c`, back to front: glow, body,
+// inner highlight (radius 5 and up) and shine. Fills `out` and returns the
+// layer count.
+int OrnamentLayers(float radius, const Color& c, bool on, OrnamentLayer out[4]);
+
+struct OrnamentSprite {
+    float x = 0.0f;
+    float y = 0.0f;
+    float extent = 0.0f; // half the quad's side
+    float u = 0.0f;      // cell center in the atlas, in texels
+    float v = 0.0f;
+};
+
+// Every ornament look (radius × palette color × on/off) baked once, glow
+// included, into one premultiplied RGBA8 texture, so an ornament is one
+// textured quad instead of four blended circle fans. The core profile
+// draws all quads with one instanced call; the legacy profile uses client
+// arrays, as RenderTarget::Composite does.
+class OrnamentAtlas {
+public:
+    bool Init(const Color* palette, int paletteSize, bool core);
+    void Destroy();
+    bool Ready() const { return texture_ != 0; }
+
+    void Begin() { sprites_.clear(); }
+    void Add(float x, float y, float radius, int paletteIndex, bool on);
+    void Flush();
+
+private:
+    void FlushCore();
+    void FlushLegacy();
+
+    std::vector<OrnamentSprite> sprites_;
+    std::vector<float> legacyVertices_;
+    int width_ = 0;
+    int height_ = 0;
+    int paletteSize_ = 0;
+    GLuint texture_ = 0;
+
+    // Core profile only.
+    GLuint program_ = 0;
+    GLint viewportLoc_ = -1;
+    GLint atlasSizeLoc_ = -1;
+    GLuint vao_ = 0;
+    GLuint meshVbo_ = 0;
+    GLuint instanceVbo_ = 0;
+};
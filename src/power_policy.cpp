@@ -0,0 +1,249 @@
+#include "power_policy.h"
+
+#include "gl_platform.h"
+
+#include <algorithm>
+#include <string>
+
+#if defined(XMASS_HAVE_X11)
+#define GLFW_EXPOSE_NATIVE_X11
+#include <GLFW/glfw3native.h>
+#include <X11/Xatom.h>
+#ifdef XMASS_HAVE_XSS
+#include <X11/extensions/scrnsaver.h>
+#endif
+#endif
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fstream>
+#endif
+
+static const std::array<PowerProfile, static_cast<size_t>(PowerState::Count)> kProfiles = {{
+    {"active", true, 0.0, 0.0},
+    {"battery", true, 1.0 / 15.0, 0.0},
+    {"obscured", false, 0.0, 1.0},
+    {"locked", false, 0.0, 2.0},
+    {"hidden", false, 0.0, -1.0},
+}};
+
+const PowerProfile& PowerProfileFor(PowerState state) {
+    return kProfiles[static_cast<size_t>(state)];
+}
+
+#if defined(XMASS_HAVE_X11)
+struct X11Atoms {
+    Display* display = nullptr;
+    // A second connection that only carries VisibilityNotify for the
+    // window. Event masks are per client, so this leaves GLFW's own
+    // selection alone, and GLFW's event loop never sees (and drops) them.
+    Display* visibility = nullptr;
+    bool fullyObscured = false;
+    Atom netWmState = None;
+    Atom netWmStateHidden = None;
+    Atom netWmDesktop = None;
+    Atom netCurrentDesktop = None;
+};
+
+static X11Atoms g_x11{};
+
+static bool ReadCardinal(Display* dpy, Window w, Atom prop, unsigned long* out) {
+    Atom type = None;
+    int format = 0;
+    unsigned long count = 0;
+    unsigned long after = 0;
+    unsigned char* data = nullptr;
+    if (XGetWindowProperty(dpy, w, prop, 0, 1, False, XA_CARDINAL, &type, &format, &count, &after, &data) != Success) {
+        return false;
+    }
+    bool ok = data && format == 32 && count == 1;
+    if (ok) *out = reinterpret_cast<unsigned long*>(data)[0];
+    if (data) XFree(data);
+    return ok;
+}
+
+static bool HasWmStateHidden(Display* dpy, Window w) {
+    Atom type = None;
+    int format = 0;
+    unsigned long count = 0;
+    unsigned long after = 0;
+    unsigned char* data = nullptr;
+    if (XGetWindowProperty(dpy, w, g_x11.netWmState, 0, 64, False, XA_ATOM, &type, &format, &count, &after, &data) != Success) {
+        return false;
+    }
+    bool hidden = false;
+    if (data && format == 32) {
+        const Atom* atoms = reinterpret_cast<const Atom*>(data);
+        for (unsigned long i = 0; i < count; ++i) {
+            if (atoms[i] == g_x11.netWmStateHidden) hidden = true;
+        }
+    }
+    if (data) XFree(data);
+    return hidden;
+}
+
+// Takes the latest VisibilityNotify state off the visibility connection.
+static void DrainVisibilityEvents() {
+    Display* dpy = g_x11.visibility;
+    if (!dpy) return;
+    while (XPending(dpy) > 0) {
+        XEvent event;
+        XNextEvent(dpy, &event);
+        if (event.type == VisibilityNotify) {
+            g_x11.fullyObscured = event.xvisibility.state == VisibilityFullyObscured;
+        }
+    }
+}
+#endif
+
+PowerPolicy::~PowerPolicy() {
+#if defined(XMASS_HAVE_X11)
+    if (g_x11.visibility) XCloseDisplay(g_x11.visibility);
+    g_x11.visibility = nullptr;
+#endif
+}
+
+void PowerPolicy::Attach(GLFWwindow* window) {
+    window_ = window;
+#if defined(XMASS_HAVE_X11)
+    if (glfwGetPlatform() == GLFW_PLATFORM_X11) {
+        g_x11.display = glfwGetX11Display();
+        if (g_x11.display) {
+            g_x11.netWmState = XInternAtom(g_x11.display, "_NET_WM_STATE", False);
+            g_x11.netWmStateHidden = XInternAtom(g_x11.display, "_NET_WM_STATE_HIDDEN", False);
+            g_x11.netWmDesktop = XInternAtom(g_x11.display, "_NET_WM_DESKTOP", False);
+            g_x11.netCurrentDesktop = XInternAtom(g_x11.display, "_NET_CURRENT_DESKTOP", False);
+            g_x11.visibility = XOpenDisplay(DisplayString(g_x11.display));
+            if (g_x11.visibility) {
+                XSelectInput(g_x11.visibility, glfwGetX11Window(window), VisibilityChangeMask);
+                XFlush(g_x11.visibility);
+            }
+        }
+    }
+#endif
+}
+
+bool PowerPolicy::ProbeObscured() {
+#if defined(XMASS_HAVE_X11)
+    Display* dpy = g_x11.display;
+    Window w = dpy ? glfwGetX11Window(window_) : 0;
+    if (!dpy || !w) return false;
+
+    DrainVisibilityEvents();
+    if (g_x11.fullyObscured || HasWmStateHidden(dpy, w)) return true;
+
+    unsigned long windowDesktop = 0;
+    unsigned long currentDesktop = 0;
+    if (ReadCardinal(dpy, w, g_x11.netWmDesktop, &windowDesktop) &&
+        ReadCardinal(dpy, DefaultRootWindow(dpy), g_x11.netCurrentDesktop, &currentDesktop)) {
+        // 0xFFFFFFFF means "on all desktops".
+        return windowDesktop != 0xFFFFFFFFul && windowDesktop != currentDesktop;
+    }
+#endif
+    return false;
+}
+
+bool PowerPolicy::ProbeScreenLocked() {
+#if defined(XMASS_HAVE_X11) && defined(XMASS_HAVE_XSS)
+    Display* dpy = g_x11.display;
+    if (!dpy) return false;
+    int eventBase = 0;
+    int errorBase = 0;
+    if (!XScreenSaverQueryExtension(dpy, &eventBase, &errorBase)) return false;
+
+    XScreenSaverInfo* info = XScreenSaverAllocInfo();
+    if (!info) return false;
+    bool on = XScreenSaverQueryInfo(dpy, DefaultRootWindow(dpy), info) && info->state == ScreenSaverOn;
+    XFree(info);
+    return on;
+#else
+    return false;
+#endif
+}
+
+#ifdef __linux__
+static std::string ReadSysfsLine(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+#endif
+
+bool PowerPolicy::ProbeOnBattery() {
+#if defined(_WIN32)
+    SYSTEM_POWER_STATUS status{};
+    return GetSystemPowerStatus(&status) && status.ACLineStatus == 0;
+#elif defined(__linux__)
+    DIR* dir = opendir("/sys/class/power_supply");
+    if (!dir) return false;
+
+    bool hasMains = false;
+    bool mainsOnline = false;
+    bool discharging = false;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        std::string base = std::string("/sys/class/power_supply/") + entry->d_name + "/";
+        // Peripheral batteries (mice, headsets) report scope "Device".
+        if (ReadSysfsLine(base + "scope") == "Device") continue;
+
+        std::string type = ReadSysfsLine(base + "type");
+        if (type == "Mains") {
+            hasMains = true;
+            mainsOnline |= ReadSysfsLine(base + "online") == "1";
+        } else if (type == "Battery") {
+            discharging |= ReadSysfsLine(base + "status") == "Discharging";
+        }
+    }
+    closedir(dir);
+    return hasMains ? !mainsOnline : discharging;
+#else
+    return false;
+#endif
+}
+
+PowerState PowerPolicy::Update(double now) {
+    counters_[static_cast<size_t>(state_)].seconds += std::max(0.0, now - lastUpdate_);
+    lastUpdate_ = now;
+
+    bool hidden = glfwGetWindowAttrib(window_, GLFW_VISIBLE) != GLFW_TRUE ||
+                  glfwGetWindowAttrib(window_, GLFW_ICONIFIED) == GLFW_TRUE;
+
+    if (!hidden && now >= nextDisplayProbe_) {
+        obscured_ = ProbeObscured();
+        screenLocked_ = ProbeScreenLocked();
+        nextDisplayProbe_ = now + 1.0;
+    }
+    if (now >= nextBatteryProbe_) {
+        onBattery_ = ProbeOnBattery();
+        nextBatteryProbe_ = now + 10.0;
+    }
+
+    if (hidden) {
+        state_ = PowerState::Hidden;
+    } else if (screenLocked_) {
+        state_ = PowerState::ScreenLocked;
+    } else if (obscured_) {
+        state_ = PowerState::Obscured;
+    } else if (onBattery_) {
+        state_ = PowerState::OnBattery;
+    } else {
+        state_ = PowerState::Active;
+    }
+    return state_;
+}
+
+void PowerPolicy::Report(std::FILE* out) const {
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        const PowerStateCounters& c = counters_[i];
+        if (c.wakeups == 0 && c.seconds <= 0.0) continue;
+        std::fprintf(
+            out,
+            "power: %-8s %7.1fs wakeups=%llu renders=%llu\n",
+            kProfiles[i].name,
+            c.seconds,
+            static_cast<unsigned long long>(c.wakeups),
+            static_cast<unsigned long long>(c.renders));
+    }
+    std::fflush(out);
+}
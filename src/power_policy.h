@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+struct GLFWwindow;
+
+enum class PowerState : int {
+    Active,       // visible, on AC power
+    OnBattery,    // visible, running from battery
+    Obscured,     // mapped but not on screen (other workspace, WM-hidden, fully covered)
+    ScreenLocked, // screensaver or lock screen is up
+    Hidden,       // iconified or hidden to the tray
+    Count,
+};
+
+struct PowerProfile {
+    const char* name = "";
+    bool renders = true;
+    double frameInterval = 0.0; // spacing between tick-driven frames
+    double pollInterval = 0.0;  // wait between re-checks when not rendering; < 0 waits for an event
+};
+
+const PowerProfile& PowerProfileFor(PowerState state);
+
+struct PowerStateCounters {
+    uint64_t wakeups = 0;
+    uint64_t renders = 0;
+    double seconds = 0.0;
+};
+
+// Decides how hard the overlay may run. GLFW window attributes cover
+// hidden/iconified everywhere. On Linux/X11, _NET_WM_STATE_HIDDEN, the
+// EWMH desktop, VisibilityNotify and the screensaver extension detect an
+// overlay nobody can see, and /sys/class/power_supply detects battery
+// power. Windows uses GetSystemPowerStatus for the latter.
+//
+// VisibilityFullyObscured (a window completely covered by others) is only
+// reported without a compositing manager: composited windows render
+// offscreen and always count as unobscured, so under a compositor a
+// covered overlay keeps drawing.
+class PowerPolicy {
+public:
+    ~PowerPolicy();
+
+    void Attach(GLFWwindow* window);
+
+    // Re-evaluates the state. Window attributes are read every call; the
+    // platform probes are rate limited.
+    PowerState Update(double now);
+    PowerState State() const { return state_; }
+
+    void CountWakeup() { ++counters_[static_cast<size_t>(state_)].wakeups; }
+    void CountRender() { ++counters_[static_cast<size_t>(state_)].renders; }
+    const PowerStateCounters& Counters(PowerState state) const { return counters_[static_cast<size_t>(state)]; }
+    void Report(std::FILE* out) const;
+
+private:
+    bool ProbeObscured();
+    bool ProbeScreenLocked();
+    bool ProbeOnBattery();
+
+    GLFWwindow* window_ = nullptr;
+    PowerState state_ = PowerState::Active;
+    double lastUpdate_ = 0.0;
+    double nextDisplayProbe_ = 0.0;
+    double nextBatteryProbe_ = 0.0;
+    bool obscured_ = false;
+    bool screenLocked_ = false;
+    bool onBattery_ = false;
+    std::array<PowerStateCounters, static_cast<size_t>(PowerState::Count)> counters_{};
+};
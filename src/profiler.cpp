@@ -0,0 +1,153 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+Profiler g_profiler;
+
+int Profiler::RegisterStage(const char* name) {
+    std::lock_guard<std::mutex> guard(registerLock_);
+    const int count = stageCount_.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; ++i) {
+        if (stageNames_[static_cast<size_t>(i)] == name) return i;
+    }
+    if (count == kMaxStages) return -1;
+    stageNames_[static_cast<size_t>(count)] = name;
+    stageCount_.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+void Profiler::Leave(int stage, uint64_t beginNs, uint64_t endNs) {
+    --depth_;
+    if (stage < 0) return;
+    const float ms = static_cast<float>(endNs - beginNs) * 1.0e-6f;
+    current_.stageMs[static_cast<size_t>(stage)] += ms;
+    if (depth_ == 0) current_.busyMs += ms;
+    if (traceFramesLeft_ > 0) trace_.push_back({stage, beginNs, endNs - beginNs});
+}
+
+void Profiler::FrameBoundary() {
+    const uint64_t now = NowNs();
+    if (frameBeginNs_ != 0) {
+        current_.intervalMs = static_cast<float>(now - frameBeginNs_) * 1.0e-6f;
+        history_[head_] = current_;
+        head_ = (head_ + 1) % kHistory;
+        count_ = std::min<size_t>(count_ + 1, kHistory);
+
+        if (traceFramesLeft_ > 0) {
+            trace_.push_back({-1, frameBeginNs_, now - frameBeginNs_});
+            if (--traceFramesLeft_ == 0) FinishTrace();
+        }
+    }
+    current_ = FrameSample{};
+    frameBeginNs_ = now;
+}
+
+void Profiler::StartTrace(const char* path, int frames) {
+    tracePath_ = path;
+    traceFrames_ = std::max(1, frames);
+    traceFramesLeft_ = traceFrames_;
+    trace_.clear();
+    trace_.reserve(static_cast<size_t>(traceFrames_) * 64);
+}
+
+void Profiler::FinishTrace() {
+    if (tracePath_.empty()) return;
+    const int frames = traceFrames_ - traceFramesLeft_;
+    traceFramesLeft_ = 0;
+
+    std::FILE* f = std::fopen(tracePath_.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "trace: cannot write %s\n", tracePath_.c_str());
+        tracePath_.clear();
+        return;
+    }
+
+    // Frames go on their own track above the markers, which all run on the
+    // main thread.
+    uint64_t origin = UINT64_MAX;
+    for (const TraceEvent& e : trace_) origin = std::min(origin, e.beginNs);
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"frames\"}},\n");
+    std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"main\"}}");
+    int frameIndex = 0;
+    for (const TraceEvent& e : trace_) {
+        const double ts = static_cast<double>(e.beginNs - origin) * 1.0e-3;
+        const double dur = static_cast<double>(e.durNs) * 1.0e-3;
+        if (e.stage < 0) {
+            std::fprintf(f, ",\n{\"name\":\"Frame %d\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}", frameIndex++, ts, dur);
+        } else {
+            std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f}",
+                         stageNames_[static_cast<size_t>(e.stage)], ts, dur);
+        }
+    }
+    std::fprintf(f, "\n]}\n");
+    std::fclose(f);
+    std::fprintf(stderr, "trace: wrote %d frames (%zu events) to %s\n", frames, trace_.size(), tracePath_.c_str());
+
+    tracePath_.clear();
+    trace_.clear();
+    trace_.shrink_to_fit();
+}
+
+static ProfileSummary SummarizeHistory(const std::array<Profiler::FrameSample, Profiler::kHistory>& history, size_t head,
+                                       size_t count, int stage) {
+    ProfileSummary s;
+    if (count == 0) return s;
+
+    std::array<float, Profiler::kHistory> values{};
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        const Profiler::FrameSample& f = history[(head + Profiler::kHistory - count + i) % Profiler::kHistory];
+        float v = stage == Profiler::kInterval ? f.intervalMs : stage == Profiler::kBusy ? f.busyMs : f.stageMs[static_cast<size_t>(stage)];
+        values[i] = v;
+        sum += v;
+    }
+    std::sort(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(count));
+    auto at = [&](double p) { return values[static_cast<size_t>(p * static_cast<double>(count - 1) + 0.5)]; };
+    s.mean = sum / static_cast<double>(count);
+    s.p50 = at(0.50);
+    s.p95 = at(0.95);
+    s.p99 = at(0.99);
+    return s;
+}
+
+ProfileSummary Profiler::Summarize(int stage) const {
+    return SummarizeHistory(history_, head_, count_, stage);
+}
+
+void Profiler::AddGpuFrame(const FrameSample& sample) {
+    gpuHistory_[gpuHead_] = sample;
+    gpuHead_ = (gpuHead_ + 1) % kHistory;
+    gpuCount_ = std::min<size_t>(gpuCount_ + 1, kHistory);
+}
+
+ProfileSummary Profiler::SummarizeGpu(int stage) const {
+    return SummarizeHistory(gpuHistory_, gpuHead_, gpuCount_, stage);
+}
+
+void Profiler::Report(std::FILE* out) const {
+    if (count_ == 0) return;
+    const ProfileSummary interval = Summarize(kInterval);
+    const ProfileSummary busy = Summarize(kBusy);
+    std::fprintf(out, "profile: frames=%zu interval_mean=%.3f busy_p50=%.3f busy_p95=%.3f busy_p99=%.3f", count_, interval.mean, busy.p50,
+                 busy.p95, busy.p99);
+    if (gpuCount_ > 0 || gpuDropped_ > 0) {
+        const ProfileSummary gpu = SummarizeGpu(kBusy);
+        std::fprintf(out, " gpu_frames=%zu gpu_dropped=%llu gpu_p50=%.3f gpu_p95=%.3f gpu_p99=%.3f", gpuCount_,
+                     static_cast<unsigned long long>(gpuDropped_), gpu.p50, gpu.p95, gpu.p99);
+    }
+    std::fprintf(out, "\n");
+
+    for (int i = 0; i < StageCount(); ++i) {
+        const ProfileSummary cpu = Summarize(i);
+        std::fprintf(out, "profile: stage=%s cpu_mean=%.3f cpu_p99=%.3f", StageName(i), cpu.mean, cpu.p99);
+        if (HasGpuStage(i) && gpuCount_ > 0) {
+            const ProfileSummary gpu = SummarizeGpu(i);
+            std::fprintf(out, " gpu_mean=%.3f gpu_p99=%.3f", gpu.mean, gpu.p99);
+        }
+        std::fprintf(out, "\n");
+    }
+    std::fflush(out);
+}
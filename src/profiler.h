@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Per-stage summary over the rolling history, in milliseconds.
+struct ProfileSummary {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+};
+
+// Scoped CPU timing for the main loop and draw functions. Markers nest and
+// are folded into per-frame stage totals between two FrameBoundary calls
+// (one per presented frame). Only markers on the thread that constructed
+// the profiler (the main thread) are recorded; code that also runs on
+// SimThread, like UpdateAnimationStep, is timed there by SimThread itself.
+// The last kHistory frames feed the HUD; StartTrace additionally records
+// every marker for a number of frames and writes them as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev).
+//
+// GPU pass times from GpuProfiler arrive a few frames late and go into a
+// separate history of the same shape, where busyMs is the span from the
+// first to the last pass of the frame.
+class Profiler {
+public:
+    static constexpr int kMaxStages = 32;
+    static constexpr int kHistory = 240;
+    // Summarize() keys for the whole frame rather than one stage.
+    static constexpr int kBusy = -1;     // sum of the outermost markers
+    static constexpr int kInterval = -2; // time between frame boundaries
+
+    struct FrameSample {
+        float intervalMs = 0.0f;
+        float busyMs = 0.0f;
+        std::array<float, kMaxStages> stageMs{};
+    };
+
+    static uint64_t NowNs() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Returns the stage's index, or -1 once kMaxStages are taken (such
+    // markers are dropped). Names must outlive the profiler. Safe from any
+    // thread.
+    int RegisterStage(const char* name);
+    int StageCount() const { return stageCount_.load(std::memory_order_acquire); }
+    bool OnOwnerThread() const { return std::this_thread::get_id() == owner_; }
+    const char* StageName(int stage) const { return stageNames_[static_cast<size_t>(stage)]; }
+
+    void Enter() { ++depth_; }
+    void Leave(int stage, uint64_t beginNs, uint64_t endNs);
+    void FrameBoundary();
+
+    // Records the next `frames` frames and writes them to `path` once
+    // complete (or from FinishTrace, whichever comes first).
+    void StartTrace(const char* path, int frames);
+    bool Tracing() const { return traceFramesLeft_ > 0; }
+    void FinishTrace();
+
+    void SetHudVisible(bool visible) { hudVisible_ = visible; }
+    bool HudVisible() const { return hudVisible_; }
+
+    // Rolling history, oldest first.
+    size_t FrameCount() const { return count_; }
+    const FrameSample& Frame(size_t i) const { return history_[(head_ + kHistory - count_ + i) % kHistory]; }
+    ProfileSummary Summarize(int stage) const;
+
+    void AddGpuFrame(const FrameSample& sample);
+    void CountGpuDropped() { ++gpuDropped_; }
+    void MarkGpuStage(int stage) { gpuStages_ |= 1u << stage; }
+    bool HasGpuStage(int stage) const { return ((gpuStages_ >> stage) & 1u) != 0; }
+    size_t GpuFrameCount() const { return gpuCount_; }
+    uint64_t GpuDroppedFrames() const { return gpuDropped_; }
+    ProfileSummary SummarizeGpu(int stage) const;
+
+    // One "profile:" line for the frame and one per stage, as key=value
+    // pairs in milliseconds, for scraping from --stats output.
+    void Report(std::FILE* out) const;
+
+private:
+    struct TraceEvent {
+        int stage = 0; // -1 marks a whole frame
+        uint64_t beginNs = 0;
+        uint64_t durNs = 0;
+    };
+
+    const std::thread::id owner_ = std::this_thread::get_id();
+    std::mutex registerLock_;
+    std::array<const char*, kMaxStages> stageNames_{};
+    std::atomic<int> stageCount_{0};
+    int depth_ = 0;
+
+    FrameSample current_{};
+    uint64_t frameBeginNs_ = 0;
+    std::array<FrameSample, kHistory> history_{};
+    size_t head_ = 0;
+    size_t count_ = 0;
+    bool hudVisible_ = false;
+
+    std::array<FrameSample, kHistory> gpuHistory_{};
+    size_t gpuHead_ = 0;
+    size_t gpuCount_ = 0;
+    uint32_t gpuStages_ = 0;
+    uint64_t gpuDropped_ = 0;
+
+    std::string tracePath_;
+    int traceFramesLeft_ = 0;
+    int traceFrames_ = 0;
+    std::vector<TraceEvent> trace_;
+};
+
+extern Profiler g_profiler;
+
+class ProfileScope {
+public:
+    explicit ProfileScope(int stage) : stage_(stage), active_(g_profiler.OnOwnerThread()) {
+        if (!active_) return;
+        beginNs_ = Profiler::NowNs();
+        g_profiler.Enter();
+    }
+    ~ProfileScope() {
+        if (active_) g_profiler.Leave(stage_, beginNs_, Profiler::NowNs());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    int stage_;
+    bool active_;
+    uint64_t beginNs_ = 0;
+};
+
+// XMASS_PROFILE_SCOPE("DrawSnow") times the rest of the enclosing block.
+// Configuring with -DXMASS_PROFILER=OFF compiles every marker out.
+#ifdef XMASS_PROFILER
+#define XMASS_PROFILE_CONCAT_(a, b) a##b
+#define XMASS_PROFILE_CONCAT(a, b) XMASS_PROFILE_CONCAT_(a, b)
+#define XMASS_PROFILE_SCOPE(name)                                                              \
+    static const int XMASS_PROFILE_CONCAT(profileStage_, __LINE__) = g_profiler.RegisterStage(name); \
+    ProfileScope XMASS_PROFILE_CONCAT(profileScope_, __LINE__)(XMASS_PROFILE_CONCAT(profileStage_, __LINE__))
+#else
+#define XMASS_PROFILE_SCOPE(name) ((void)0)
+#endif
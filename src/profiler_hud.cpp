@@ -0,0 +1,135 @@
+#include "profiler_hud.h"
+
+#include "batch_renderer.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+// 3x5 glyphs, one bit per pixel, rows top to bottom with the leftmost
+// pixel in the highest bit of each 3-bit row.
+struct Glyph {
+    char c;
+    uint16_t bits;
+};
+
+static const Glyph kFont[] = {
+    {'0', 0b111'101'101'101'111}, {'1', 0b010'110'010'010'111}, {'2', 0b111'001'111'100'111},
+    {'3', 0b111'001'111'001'111}, {'4', 0b101'101'111'001'001}, {'5', 0b111'100'111'001'111},
+    {'6', 0b111'100'111'101'111}, {'7', 0b111'001'001'010'010}, {'8', 0b111'101'111'101'111},
+    {'9', 0b111'101'111'001'111}, {'A', 0b010'101'111'101'101}, {'B', 0b110'101'110'101'110},
+    {'C', 0b011'100'100'100'011}, {'D', 0b110'101'101'101'110}, {'E', 0b111'100'110'100'111},
+    {'F', 0b111'100'110'100'100}, {'G', 0b011'100'101'101'011}, {'H', 0b101'101'111'101'101},
+    {'I', 0b111'010'010'010'111}, {'J', 0b001'001'001'101'010}, {'K', 0b101'101'110'101'101},
+    {'L', 0b100'100'100'100'111}, {'M', 0b101'111'111'101'101}, {'N', 0b110'101'101'101'101},
+    {'O', 0b010'101'101'101'010}, {'P', 0b110'101'110'100'100}, {'Q', 0b010'101'101'110'011},
+    {'R', 0b110'101'110'101'101}, {'S', 0b011'100'010'001'110}, {'T', 0b111'010'010'010'010},
+    {'U', 0b101'101'101'101'111}, {'V', 0b101'101'101'101'010}, {'W', 0b101'101'111'111'101},
+    {'X', 0b101'101'010'101'101}, {'Y', 0b101'101'010'010'010}, {'Z', 0b111'001'010'100'111},
+    {'.', 0b000'000'000'000'010}, {':', 0b000'010'000'010'000}, {'-', 0b000'000'111'000'000},
+    {'/', 0b001'001'010'100'100}, {'%', 0b101'001'010'100'101}, {'=', 0b000'111'000'111'000},
+};
+
+static uint16_t GlyphBits(char c) {
+    if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+    for (const Glyph& g : kFont) {
+        if (g.c == c) return g.bits;
+    }
+    return 0;
+}
+
+static void Rect(BatchRenderer& batch, float x0, float y0, float x1, float y1, const Color& c) {
+    batch.Triangle(x0, y0, x1, y0, x1, y1, c);
+    batch.Triangle(x0, y0, x1, y1, x0, y1, c);
+}
+
+// One quad per horizontal run of lit pixels.
+static void Text(BatchRenderer& batch, float x, float y, float scale, const char* text, const Color& c) {
+    for (; *text; ++text, x += 4.0f * scale) {
+        const uint16_t bits = GlyphBits(*text);
+        if (!bits) continue;
+        for (int row = 0; row < 5; ++row) {
+            const int rowBits = (bits >> (3 * (4 - row))) & 7;
+            int col = 0;
+            while (col < 3) {
+                if (!(rowBits & (4 >> col))) {
+                    ++col;
+                    continue;
+                }
+                int end = col;
+                while (end < 3 && (rowBits & (4 >> end))) ++end;
+                Rect(batch, x + col * scale, y + row * scale, x + end * scale, y + (row + 1) * scale, c);
+                col = end;
+            }
+        }
+    }
+}
+
+void DrawProfilerHud(BatchRenderer& batch, int width, int height) {
+    XMASS_PROFILE_SCOPE("DrawProfilerHud");
+    const float scale = (width >= 360 && height >= 360) ? 2.0f : 1.0f;
+    const float lineH = 7.0f * scale;
+    const float pad = 3.0f * scale;
+    const float graphH = 20.0f * scale;
+    const int stages = g_profiler.StageCount();
+    const bool gpu = g_profiler.GpuFrameCount() > 0;
+    const int lines = (gpu ? 4 : 3) + stages;
+    const float panelW = std::min(static_cast<float>(width), 40.0f * 4.0f * scale + 2.0f * pad);
+    const float panelH = lines * lineH + graphH + 3.0f * pad;
+
+    Rect(batch, 0.0f, 0.0f, panelW, panelH, FromRGB(0, 0, 0, 0.65f));
+
+    const Color text = FromRGB(235, 235, 235);
+    const Color dim = FromRGB(150, 160, 170);
+    char buf[64];
+    float x = pad;
+    float y = pad;
+
+    const ProfileSummary interval = g_profiler.Summarize(Profiler::kInterval);
+    std::snprintf(buf, sizeof(buf), "FRAME %6.2f MS %5.1f FPS", interval.mean, interval.mean > 0.0 ? 1000.0 / interval.mean : 0.0);
+    Text(batch, x, y, scale, buf, text);
+    y += lineH;
+
+    const ProfileSummary busy = g_profiler.Summarize(Profiler::kBusy);
+    std::snprintf(buf, sizeof(buf), "BUSY P50 %.2f P95 %.2f P99 %.2f", busy.p50, busy.p95, busy.p99);
+    Text(batch, x, y, scale, buf, text);
+    y += lineH;
+    if (gpu) {
+        const ProfileSummary span = g_profiler.SummarizeGpu(Profiler::kBusy);
+        std::snprintf(buf, sizeof(buf), "GPU  P50 %.2f P95 %.2f P99 %.2f", span.p50, span.p95, span.p99);
+        Text(batch, x, y, scale, buf, text);
+        y += lineH;
+    }
+    y += pad;
+
+    // Busy time per frame, newest on the right, scaled to the worst frame
+    // in the history.
+    const size_t frames = g_profiler.FrameCount();
+    float peak = 0.1f;
+    for (size_t i = 0; i < frames; ++i) peak = std::max(peak, g_profiler.Frame(i).busyMs);
+    const float barW = (panelW - 2.0f * pad) / Profiler::kHistory;
+    const float graphX = pad + (Profiler::kHistory - frames) * barW;
+    for (size_t i = 0; i < frames; ++i) {
+        const float ms = g_profiler.Frame(i).busyMs;
+        const float h = graphH * ms / peak;
+        const Color bar = ms > busy.p95 ? FromRGB(255, 120, 80) : FromRGB(90, 200, 120);
+        Rect(batch, graphX + i * barW, y + graphH - h, graphX + (i + 1) * barW, y + graphH, bar);
+    }
+    std::snprintf(buf, sizeof(buf), "%.2f", peak);
+    Text(batch, x, y, scale, buf, dim);
+    y += graphH + pad;
+
+    std::snprintf(buf, sizeof(buf), "%-19s %6s %6s %6s", "STAGE", "CPU", "P99", gpu ? "GPU" : "");
+    Text(batch, x, y, scale, buf, dim);
+    y += lineH;
+    for (int i = 0; i < stages; ++i) {
+        const ProfileSummary s = g_profiler.Summarize(i);
+        int n = std::snprintf(buf, sizeof(buf), "%-19.19s %6.3f %6.2f", g_profiler.StageName(i), s.mean, s.p99);
+        if (gpu && g_profiler.HasGpuStage(i) && n > 0) {
+            std::snprintf(buf + n, sizeof(buf) - static_cast<size_t>(n), " %6.3f", g_profiler.SummarizeGpu(i).mean);
+        }
+        Text(batch, x, y, scale, buf, text);
+        y += lineH;
+    }
+}
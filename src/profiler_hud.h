@@ -0,0 +1,10 @@
+#pragma once
+
+class BatchRenderer;
+
+// Draws g_profiler's rolling numbers in the top-left corner: frame interval
+// and busy time with percentiles, a per-frame busy-time graph, and the mean
+// and p99 of every stage, plus GPU times once GpuProfiler has results.
+// Text uses a built-in 3x5 pixel font, so the HUD goes through the batch
+// like any other geometry (GL or software).
+void DrawProfilerHud(BatchRenderer& batch, int width, int height);
@@ -0,0 +1,183 @@
+#include "render_target.h"
+
+#include <algorithm>
+
+static const char* kCompositeVertexShader = R"(#version 330 core
+in vec2 aPos;
+out vec2 vUv;
+void main() {
+    vUv = aPos * 0.5 + 0.5;
+    gl_Position = vec4(aPos, 0.0, 1.0);
+}
+)";
+
+static const char* kCompositeFragmentShader = R"(#version 330 core
+uniform sampler2D uTexture;
+in vec2 vUv;
+out vec4 fragColor;
+void main() {
+    fragColor = texture(uTexture, vUv);
+}
+)";
+
+bool RenderTarget::Create(int width, int height, int samples) {
+    DestroySurfaces();
+    if (!g_gl.framebufferObject || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    GLint maxSamples = 0;
+    if (samples > 0) {
+        glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    }
+    samples_ = std::min(samples, static_cast<int>(maxSamples));
+    width_ = width;
+    height_ = height;
+
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    g_gl.GenFramebuffers(1, &resolveFbo_);
+    g_gl.BindFramebuffer(GL_FRAMEBUFFER, resolveFbo_);
+    g_gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_, 0);
+    bool ok = g_gl.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (ok && samples_ > 1) {
+        g_gl.GenRenderbuffers(1, &msaaColor_);
+        g_gl.BindRenderbuffer(GL_RENDERBUFFER, msaaColor_);
+        g_gl.RenderbufferStorageMultisample(GL_RENDERBUFFER, samples_, GL_RGBA8, width, height);
+        g_gl.BindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        g_gl.GenFramebuffers(1, &msaaFbo_);
+        g_gl.BindFramebuffer(GL_FRAMEBUFFER, msaaFbo_);
+        g_gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, msaaColor_);
+        if (g_gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            // Fall back to drawing straight into the texture without AA.
+            g_gl.DeleteFramebuffers(1, &msaaFbo_);
+            g_gl.DeleteRenderbuffers(1, &msaaColor_);
+            msaaFbo_ = 0;
+            msaaColor_ = 0;
+            samples_ = 0;
+        }
+    }
+
+    g_gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (ok && g_gl.coreProfile && !program_) {
+        ok = CreateCompositePipeline();
+    }
+    if (!ok) {
+        DestroySurfaces();
+    }
+    return ok;
+}
+
+bool RenderTarget::CreateCompositePipeline() {
+    const char* attributes[] = {"aPos"};
+    program_ = BuildProgram(kCompositeVertexShader, kCompositeFragmentShader, attributes, 1);
+    if (!program_) {
+        return false;
+    }
+    g_gl.UseProgram(program_);
+    g_gl.Uniform1i(g_gl.GetUniformLocation(program_, "uTexture"), 0);
+    g_gl.UseProgram(0);
+
+    // Full-viewport quad in clip space; texture rows match GL's bottom-up
+    // order, so no flip is needed here.
+    const GLfloat quad[] = {-1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f};
+    g_gl.GenVertexArrays(1, &vao_);
+    g_gl.GenBuffers(1, &vbo_);
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, vbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    g_gl.EnableVertexAttribArray(0);
+    g_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void RenderTarget::Destroy() {
+    if (vbo_) g_gl.DeleteBuffers(1, &vbo_);
+    if (vao_) g_gl.DeleteVertexArrays(1, &vao_);
+    if (program_) g_gl.DeleteProgram(program_);
+    vbo_ = 0;
+    vao_ = 0;
+    program_ = 0;
+    DestroySurfaces();
+}
+
+void RenderTarget::DestroySurfaces() {
+    if (msaaFbo_) g_gl.DeleteFramebuffers(1, &msaaFbo_);
+    if (msaaColor_) g_gl.DeleteRenderbuffers(1, &msaaColor_);
+    if (resolveFbo_) g_gl.DeleteFramebuffers(1, &resolveFbo_);
+    if (texture_) glDeleteTextures(1, &texture_);
+    msaaFbo_ = 0;
+    msaaColor_ = 0;
+    resolveFbo_ = 0;
+    texture_ = 0;
+    width_ = 0;
+    height_ = 0;
+    samples_ = 0;
+}
+
+void RenderTarget::BeginDraw() {
+    g_gl.BindFramebuffer(GL_FRAMEBUFFER, msaaFbo_ ? msaaFbo_ : resolveFbo_);
+    glViewport(0, 0, width_, height_);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void RenderTarget::EndDraw() {
+    if (msaaFbo_) {
+        g_gl.BindFramebuffer(GL_READ_FRAMEBUFFER, msaaFbo_);
+        g_gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFbo_);
+        g_gl.BlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    g_gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::Composite() const {
+    if (!texture_) return;
+    if (g_gl.coreProfile) {
+        CompositeCore();
+        return;
+    }
+
+    const float w = static_cast<float>(width_);
+    const float h = static_cast<float>(height_);
+    // The target was drawn with the same top-left projection, so its first
+    // row holds the bottom of the image.
+    const GLfloat positions[] = {0.0f, 0.0f, w, 0.0f, w, h, 0.0f, h};
+    const GLfloat texCoords[] = {0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f};
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, positions);
+    glTexCoordPointer(2, GL_FLOAT, 0, texCoords);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
+
+void RenderTarget::CompositeCore() const {
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    g_gl.UseProgram(program_);
+    g_gl.BindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    g_gl.BindVertexArray(0);
+    g_gl.UseProgram(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
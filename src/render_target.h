@@ -0,0 +1,46 @@
+#pragma once
+
+#include "gl_ext.h"
+
+// Offscreen color target backed by a texture. When multisampling is
+// requested, drawing goes to a multisampled renderbuffer that EndDraw()
+// blits into the texture. The texture holds premultiplied alpha.
+class RenderTarget {
+public:
+    ~RenderTarget() { Destroy(); }
+
+    // Reallocates the texture and framebuffers. The core profile's
+    // composite program is built by the first call and kept until Destroy,
+    // so resizing does not recompile it.
+    bool Create(int width, int height, int samples);
+    void Destroy();
+
+    bool Valid() const { return texture_ != 0; }
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+
+    void BeginDraw();
+    void EndDraw();
+
+    // Draws the texture as one quad covering (0, 0)-(width, height) in the
+    // current top-left origin projection.
+    void Composite() const;
+
+private:
+    bool CreateCompositePipeline();
+    void DestroySurfaces();
+    void CompositeCore() const;
+
+    int width_ = 0;
+    int height_ = 0;
+    int samples_ = 0;
+    GLuint texture_ = 0;
+    GLuint resolveFbo_ = 0;
+    GLuint msaaFbo_ = 0;
+    GLuint msaaColor_ = 0;
+
+    // Core profile only.
+    GLuint program_ = 0;
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+};
@@ -0,0 +1,86 @@
+#include "rng.h"
+
+static uint64_t SplitMix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void Rng::Seed(uint64_t seed, uint64_t stream) {
+    uint64_t x = seed;
+    for (uint64_t& s : s_) {
+        s = SplitMix64(x);
+    }
+    for (uint64_t i = 0; i < stream; ++i) {
+        Jump();
+    }
+}
+
+void Rng::Jump() {
+    static const uint64_t kJump[] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (uint64_t jump : kJump) {
+        for (int b = 0; b < 64; ++b) {
+            if (jump & (1ull << b)) {
+                s0 ^= s_[0];
+                s1 ^= s_[1];
+                s2 ^= s_[2];
+                s3 ^= s_[3];
+            }
+            Next();
+        }
+    }
+    s_[0] = s0;
+    s_[1] = s1;
+    s_[2] = s2;
+    s_[3] = s3;
+}
+
+void Rng::FillFloats(float* out, size_t n, float lo, float hi) {
+    // Two 24-bit floats per 64-bit draw. Works on a local copy so the state
+    // stays in registers across the stores to `out`.
+    Rng local = *this;
+    const float scale = (hi - lo) * (1.0f / 16777216.0f);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64_t bits = local.Next();
+        out[i] = lo + static_cast<float>(bits >> 40) * scale;
+        out[i + 1] = lo + static_cast<float>((bits >> 16) & 0xFFFFFF) * scale;
+    }
+    if (i < n) {
+        out[i] = lo + static_cast<float>(local.Next() >> 40) * scale;
+    }
+    *this = local;
+}
+
+uint64_t Rng::BernoulliMask(double p) {
+    if (p <= 0.0) return 0;
+    if (p >= 1.0) return ~0ull;
+    uint32_t k = static_cast<uint32_t>(p * 65536.0 + 0.5);
+    if (k == 0) return 0;
+    if (k >= 65536) return ~0ull;
+
+    // Build the mask from the binary expansion of k / 2^16, least
+    // significant bit first: a set bit ORs in a fresh word (p -> (1 + p) / 2),
+    // a clear bit ANDs one in (p -> p / 2).
+    int bits = 16;
+    while (!(k & 1)) {
+        k >>= 1;
+        --bits;
+    }
+    uint64_t mask = Next();
+    for (int i = 1; i < bits; ++i) {
+        k >>= 1;
+        mask = (k & 1) ? (mask | Next()) : (mask & Next());
+    }
+    return mask;
+}
+
+void Rng::GetState(uint64_t out[4]) const {
+    for (int i = 0; i < 4; ++i) out[i] = s_[i];
+}
+
+void Rng::SetState(const uint64_t in[4]) {
+    for (int i = 0; i < 4; ++i) s_[i] = in[i];
+}
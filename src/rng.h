@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// xoshiro256** generator. Much cheaper per draw than std::mt19937 plus a
+// std::uniform_*_distribution, and it has bulk helpers for the scene
+// generator and the blink update.
+class Rng {
+public:
+    // The state is expanded from `seed` with splitmix64. Each `stream` is
+    // then advanced by 2^128 steps, so streams created from the same seed
+    // never overlap.
+    Rng() { Seed(0x9E3779B97F4A7C15ull); }
+    explicit Rng(uint64_t seed, uint64_t stream = 0) { Seed(seed, stream); }
+
+    void Seed(uint64_t seed, uint64_t stream = 0);
+    void Jump();
+
+    uint64_t Next() {
+        const uint64_t result = Rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = Rotl(s_[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, 1) with 24 bits of precision.
+    float Float01() { return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f); }
+    float Float(float lo, float hi) { return lo + (hi - lo) * Float01(); }
+
+    // Uniform in [lo, hi] (inclusive). Uses a 32x32 multiply-shift, so the
+    // bias is below 2^-32 for the small ranges used here.
+    int Int(int lo, int hi) {
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(hi) - lo + 1);
+        return lo + static_cast<int>(((Next() >> 32) * range) >> 32);
+    }
+
+    void FillFloats(float* out, size_t n, float lo, float hi);
+
+    // 64 independent coin flips, each set with probability `p` (rounded to
+    // 1/65536). Costs at most 16 draws instead of 64.
+    uint64_t BernoulliMask(double p);
+
+    // Serialisable state, for snapshots and reproducible runs.
+    void GetState(uint64_t out[4]) const;
+    void SetState(const uint64_t in[4]);
+
+private:
+    static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t s_[4] = {};
+};
@@ -0,0 +1,1165 @@
+#include "scene.h"
+
+#include "batch_renderer.h"
+#include "gpu_profiler.h"
+#include "gpu_snow.h"
+#include "needle_renderer.h"
+#include "ornament_atlas.h"
+#include "profiler.h"
+#include "profiler_hud.h"
+#include "render_target.h"
+#include "scene_file.h"
+#include "sdf_renderer.h"
+#include "snow_renderer.h"
+#include "soft_rasterizer.h"
+#include "tessellation.h"
+#include "triple_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <type_traits>
+
+AppState g_state{};
+SceneOptions g_sceneOptions{};
+ThreadPool g_pool;
+ThreadPool g_simPool;
+
+// Simulation side: g_sceneVersion counts RegenerateScene/ResizeScene calls
+// and g_geometry is the geometry last published for it.
+static uint64_t g_sceneVersion = 0;
+static std::shared_ptr<const SceneGeometry> g_geometry;
+static TripleBuffer<SceneSnapshot> g_snapshots;
+// Where the current ornamentOn and snow positions are: the snapshot slot
+// the last tick wrote, or g_state itself (nullptr) after anything that
+// edited them there. See StageTickState.
+static const SceneSnapshot* g_tickSource = nullptr;
+// Ticks only change the speed, drift and size of the flakes they
+// respawn, so slots catch up on those from the recent ticks' respawn
+// lists instead of copying the arrays. A second of ticks covers a slot
+// the renderer held through a slow frame. g_snowTicks counts the ticks
+// that stepped the SnowField; tick t's list is g_respawnHistory[t % 32].
+constexpr uint64_t kRespawnHistory = 32;
+static std::array<std::vector<uint32_t>, kRespawnHistory> g_respawnHistory;
+static uint64_t g_snowTicks = 0;
+
+static BatchRenderer g_batch;
+static OrnamentAtlas g_ornamentAtlas;
+static SdfRenderer g_sdf; // --aa=sdf; replaces the batch's shapes
+static NeedleRenderer g_needleRenderer;
+static SnowRenderer g_snowRenderer;
+static GpuSnow g_gpuSnow;
+static SoftRasterizer g_softTree;
+static SoftRasterizer g_softFrame;
+static RenderTarget g_treeCache;
+// The size g_treeCache was last created for. It is kept when Create fails
+// (no FBO support, say), so a failed size is not retried every frame.
+static int g_treeCacheWidth = 0;
+static int g_treeCacheHeight = 0;
+// Render side: the geometry version each cache was last built from.
+static uint64_t g_treeCacheVersion = 0;
+static uint64_t g_softTreeVersion = 0;
+static uint64_t g_gpuSnowVersion = 0;
+static uint64_t g_snowRendererVersion = 0;
+static uint64_t g_snowRendererTick = 0;
+
+static int ClampInt(int v, int lo, int hi) {
+    return std::max(lo, std::min(hi, v));
+}
+
+// Ornament and needle positions as fractions of the window size. `scale`
+// is UnitScale(size).
+static float UnitScale(int size) {
+    return 65535.0f / static_cast<float>(size);
+}
+
+static uint16_t ToUnit16(float v, float scale) {
+    return static_cast<uint16_t>(std::max(0.0f, std::min(65535.0f, v * scale + 0.5f)));
+}
+
+static float FromUnit16(uint16_t v, int size) {
+    return static_cast<float>(v) * (static_cast<float>(size) / 65535.0f);
+}
+
+// Needle offsets in 1/16 px.
+static int8_t ToSixteenths(float v) {
+    const float s = v * 16.0f;
+    return static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, s + (s < 0.0f ? -0.5f : 0.5f))));
+}
+
+static const std::array<Color, 6> kPalette = {
+    FromRGB(255, 60, 60),   // red
+    FromRGB(60, 220, 80),   // green
+    FromRGB(255, 210, 60),  // gold
+    FromRGB(80, 160, 255),  // blue
+    FromRGB(255, 120, 240), // pink
+    FromRGB(255, 255, 255), // white
+};
+
+// Needles sit within 95% of the half-width and only where that leaves at
+// least 6 px.
+static constexpr float kNeedleSpread = 0.95f;
+static constexpr float kNeedleMinHalfWidth = 6.0f;
+
+// Submits everything queued, keeping the painter's order: with --aa=sdf the
+// scene's shapes are all in g_sdf and only the HUD is left in g_batch.
+static void FlushShapes() {
+    g_sdf.Flush();
+    g_batch.Flush();
+}
+
+// With GPU profiling on, a pass flushes the batch on entry and exit so that
+// exactly its own draw calls land between its two timestamps. This splits
+// draw calls the batch would otherwise merge, so GPU times read slightly
+// high while profiling.
+class GpuPassScope {
+public:
+    explicit GpuPassScope(int stage) : active_(g_gpuProfiler.Active()) {
+        if (!active_) return;
+        FlushShapes();
+        g_gpuProfiler.BeginPass(stage);
+    }
+    ~GpuPassScope() {
+        if (!active_) return;
+        FlushShapes();
+        g_gpuProfiler.EndPass();
+    }
+    GpuPassScope(const GpuPassScope&) = delete;
+    GpuPassScope& operator=(const GpuPassScope&) = delete;
+
+private:
+    bool active_;
+};
+
+// A CPU marker plus a GPU pass under the same stage name.
+#ifdef XMASS_PROFILER
+#define SCENE_GPU_PASS(name) \
+    XMASS_PROFILE_SCOPE(name); \
+    GpuPassScope XMASS_PROFILE_CONCAT(gpuPass_, __LINE__)(XMASS_PROFILE_CONCAT(profileStage_, __LINE__))
+#else
+#define SCENE_GPU_PASS(name) ((void)0)
+#endif
+
+void ShutdownRenderer() {
+    g_treeCache.Destroy();
+    g_ornamentAtlas.Destroy();
+    g_sdf.Destroy();
+    g_needleRenderer.Destroy();
+    g_snowRenderer.Destroy();
+    g_gpuSnow.Destroy();
+    g_batch.DestroyCore();
+    g_gpuProfiler.Destroy();
+    g_treeCacheVersion = 0;
+    g_treeCacheWidth = 0;
+    g_treeCacheHeight = 0;
+    g_gpuSnowVersion = 0;
+    g_snowRendererVersion = 0;
+    g_snowRendererTick = 0;
+}
+
+bool InitRenderer(GLProcLoader loader, bool core) {
+    if (!LoadGLFunctions(loader, core)) {
+        return false;
+    }
+    g_gpuProfiler.Init();
+    const bool sdf = core && g_sceneOptions.sdfAntialias;
+    if (!g_ornamentAtlas.Init(kPalette.data(), static_cast<int>(kPalette.size()), core) ||
+        (core && (!g_batch.InitCore() || (sdf && !g_sdf.Init()) || !g_needleRenderer.Init(sdf) || !g_snowRenderer.Init(sdf)))) {
+        ShutdownRenderer();
+        return false;
+    }
+    // Only compiled when asked for; without it ResolveGpuSnow falls back to
+    // CPU snow.
+    if (core && g_sceneOptions.gpuSnow) {
+        g_gpuSnow.Init(sdf);
+    }
+
+    if (!sdf) {
+        glEnable(GL_MULTISAMPLE);
+        glEnable(GL_LINE_SMOOTH);
+        glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+    }
+    return true;
+}
+
+static void RebuildTreeGeometry() {
+    const int w = g_state.width;
+    const int h = g_state.height;
+
+    g_state.treeCx = w * 0.5f;
+    g_state.treeTopY = h * 0.11f;
+    g_state.treeBottomY = h * 0.80f;
+    g_state.treeBaseHalfW = w * 0.30f;
+
+    g_state.layerCount = ClampInt(w / 70, 5, 9);
+    g_state.layerHeight = (g_state.treeBottomY - g_state.treeTopY) / static_cast<float>(g_state.layerCount);
+    g_state.layerOverlap = g_state.layerHeight * 0.65f;
+
+    g_state.layers.clear();
+    g_state.layers.reserve(static_cast<size_t>(g_state.layerCount));
+
+    for (int i = 0; i < g_state.layerCount; ++i) {
+        float y0 = g_state.treeTopY + i * g_state.layerHeight;
+        float y1 = (i == g_state.layerCount - 1) ? g_state.treeBottomY : (y0 + g_state.layerHeight + g_state.layerOverlap);
+        float progress = static_cast<float>(i + 1) / static_cast<float>(g_state.layerCount);
+        float halfW = g_state.treeBaseHalfW * std::pow(progress, 1.25f);
+        g_state.layers.push_back({y0, y1, halfW});
+    }
+
+    g_state.profile.Build(g_state.layers, g_state.treeTopY, g_state.treeBottomY, kNeedleMinHalfWidth / kNeedleSpread);
+}
+
+bool GpuSnowActive() {
+    return g_sceneOptions.gpuSnow;
+}
+
+size_t GpuSnowCount() {
+    return g_state.snowSeeds.size();
+}
+
+// Scratch for the bulk placement draws, kept across calls.
+static std::vector<float> g_uniforms;
+
+static int OrnamentTarget() {
+    return ClampInt((g_state.width * g_state.height) / 25000, 35, 400);
+}
+
+static int NeedleTarget() {
+    if (g_sceneOptions.needleBudget > 0) return g_sceneOptions.needleBudget;
+    return ClampInt((g_state.width * g_state.height) / 900, 300, 2000);
+}
+
+static int SnowTarget() {
+    if (g_sceneOptions.snowBudget > 0) return g_sceneOptions.snowBudget;
+    return ClampInt(g_state.width / 8, 60, 220);
+}
+
+// The Add* helpers append to the current scene, placed on the current
+// silhouette. RegenerateScene fills an empty scene with them; ResizeScene
+// only tops up.
+static void AddOrnaments(int count) {
+    if (count <= 0) return;
+    // Placement draws are filled in bulk up front: [0, n) vertical
+    // positions, [n, 2n) horizontal offsets in -1..1.
+    Rng& rng = g_state.rng;
+    g_uniforms.resize(static_cast<size_t>(count) * 2);
+    rng.FillFloats(g_uniforms.data(), count, 0.0f, 1.0f);
+    rng.FillFloats(g_uniforms.data() + count, count, -1.0f, 1.0f);
+    const size_t first = g_state.ornaments.size();
+    g_state.ornaments.reserve(first + static_cast<size_t>(count));
+    g_state.ornamentOn.resize((first + static_cast<size_t>(count) + 63) / 64, 0);
+    uint64_t onBits = 0;
+    for (int i = 0; i < count; ++i) {
+        float t = std::pow(g_uniforms[i], 0.70f);
+        float y = g_state.treeTopY + t * (g_state.treeBottomY - g_state.treeTopY);
+        float halfW = g_state.profile.HalfWidthAt(y) * 0.92f;
+        float x = g_state.treeCx + g_uniforms[count + i] * halfW;
+
+        if (i % 64 == 0) {
+            onBits = rng.Next();
+        }
+
+        Ornament o;
+        o.x = ToUnit16(x, UnitScale(g_state.width));
+        o.y = ToUnit16(y, UnitScale(g_state.height));
+        o.radius = static_cast<uint8_t>(rng.Int(kOrnamentMinRadius, kOrnamentMaxRadius));
+        o.paletteA = static_cast<uint8_t>(rng.Int(0, static_cast<int>(kPalette.size() - 1)));
+        o.paletteB = static_cast<uint8_t>(rng.Int(0, static_cast<int>(kPalette.size() - 1)));
+        // Set or cleared, as the bits past the last ornament are garbage.
+        const size_t index = first + static_cast<size_t>(i);
+        const uint64_t bit = uint64_t{1} << (index % 64);
+        uint64_t& word = g_state.ornamentOn[index / 64];
+        word = ((onBits >> (i % 64)) & 1) ? (word | bit) : (word & ~bit);
+        g_state.ornaments.push_back(o);
+    }
+}
+
+static void AddNeedles(int count) {
+    if (count <= 0) return;
+    // Needles take four floats each: area quantile (uniform over the
+    // silhouette via the profile's inverse CDF), horizontal offset, stroke
+    // length and vertical tilt.
+    Rng& rng = g_state.rng;
+    g_uniforms.resize(static_cast<size_t>(count) * 4);
+    float* needleT = g_uniforms.data();
+    float* needleU = needleT + count;
+    float* needleLen = needleU + count;
+    float* needleDy = needleLen + count;
+    rng.FillFloats(needleT, count, 0.0f, 1.0f);
+    rng.FillFloats(needleU, count, -1.0f, 1.0f);
+    rng.FillFloats(needleLen, count, 2.5f, 6.5f);
+    rng.FillFloats(needleDy, count, -1.4f, 1.4f);
+    g_state.needles.reserve(g_state.needles.size() + static_cast<size_t>(count));
+    // The shades rng.Int(-22, 26) picks from, packed once.
+    std::array<Rgba8, 49> shades;
+    for (size_t i = 0; i < shades.size(); ++i) {
+        Color c = AdjustColor(FromRGB(8, 120, 45), static_cast<int>(i) - 22);
+        c.a = 0.55f;
+        shades[i] = PackColor(c);
+    }
+    const float scaleX = UnitScale(g_state.width);
+    const float scaleY = UnitScale(g_state.height);
+    for (int i = 0; i < count; ++i) {
+        float y = g_state.profile.SampleY(needleT[i]);
+        float halfW = g_state.profile.HalfWidthAt(y) * kNeedleSpread;
+        float x = g_state.treeCx + needleU[i] * halfW;
+
+        float dir = (x < g_state.treeCx) ? -1.0f : 1.0f;
+        float len = needleLen[i];
+        float dy = needleDy[i];
+        float dx = dir * len;
+
+        NeedleStroke n;
+        n.x = ToUnit16(x, scaleX);
+        n.y = ToUnit16(y, scaleY);
+        n.dx = ToSixteenths(dx);
+        n.dy = ToSixteenths(dy);
+        n.c = shades[static_cast<size_t>(rng.Int(-22, 26) + 22)];
+        g_state.needles.push_back(n);
+    }
+}
+
+// Flakes start anywhere in the window, not just above it.
+static void AddSnow(int count) {
+    if (count <= 0) return;
+    Rng& rng = g_state.rng;
+    if (GpuSnowActive()) {
+        for (int i = 0; i < count; ++i) {
+            g_state.snowSeeds.push_back(static_cast<uint32_t>(rng.Next() >> 32));
+        }
+        return;
+    }
+    SnowField& snow = g_state.snow;
+    const size_t first = snow.Size();
+    snow.Resize(first + static_cast<size_t>(count));
+    rng.FillFloats(snow.x.data() + first, count, 0.0f, static_cast<float>(g_state.width));
+    rng.FillFloats(snow.y.data() + first, count, 0.0f, static_cast<float>(g_state.height));
+    rng.FillFloats(snow.speed.data() + first, count, 0.5f, 1.8f);
+    rng.FillFloats(snow.drift.data() + first, count, -0.3f, 0.3f);
+    for (size_t i = first; i < snow.Size(); ++i) {
+        snow.radius[i] = static_cast<float>(rng.Int(1, 3));
+    }
+}
+
+// Copies the tick state back from the snapshot slot holding it, before
+// g_state's copy is edited or read.
+static void StageTickState() {
+    if (!g_tickSource) return;
+    g_state.ornamentOn.assign(g_tickSource->ornamentOn.begin(), g_tickSource->ornamentOn.end());
+    g_state.snow.x.assign(g_tickSource->snowX.begin(), g_tickSource->snowX.end());
+    g_state.snow.y.assign(g_tickSource->snowY.begin(), g_tickSource->snowY.end());
+    g_tickSource = nullptr;
+}
+
+void RegenerateScene(int w, int h) {
+    XMASS_PROFILE_SCOPE("RegenerateScene");
+    // Everything is replaced, so there is nothing to stage.
+    g_tickSource = nullptr;
+    g_state.width = std::max(200, w);
+    g_state.height = std::max(200, h);
+
+    RebuildTreeGeometry();
+    ++g_sceneVersion;
+
+    g_state.ornaments.clear();
+    g_state.ornamentOn.clear();
+    AddOrnaments(OrnamentTarget());
+    g_state.needles.clear();
+    AddNeedles(NeedleTarget());
+
+    g_state.snowTick = 0.0;
+    g_state.snow.Clear();
+    g_state.snowSeeds.clear();
+    AddSnow(SnowTarget());
+}
+
+void ResolveGpuSnow() {
+    if (!g_sceneOptions.gpuSnow || g_gpuSnow.Ready()) return;
+    g_sceneOptions.gpuSnow = false;
+    if (g_state.snowSeeds.empty()) return;
+    StageTickState();
+    g_state.snowSeeds.clear();
+    AddSnow(SnowTarget());
+    ++g_sceneVersion;
+}
+
+void ResizeScene(int w, int h) {
+    XMASS_PROFILE_SCOPE("ResizeScene");
+    w = std::max(200, w);
+    h = std::max(200, h);
+    if (w == g_state.width && h == g_state.height) return;
+    StageTickState();
+
+    // The tree's anchors are all proportional to the window, so scaling
+    // positions keeps everything in place relative to it. Ornaments and
+    // needles already store theirs that way; sizes (ornament radii, needle
+    // strokes, flakes) stay in pixels.
+    const float sx = static_cast<float>(w) / static_cast<float>(g_state.width);
+    const float sy = static_cast<float>(h) / static_cast<float>(g_state.height);
+    g_state.width = w;
+    g_state.height = h;
+    RebuildTreeGeometry();
+    ++g_sceneVersion;
+
+    SnowField& snow = g_state.snow;
+    for (size_t i = 0; i < snow.Size(); ++i) {
+        snow.x[i] *= sx;
+        snow.y[i] *= sy;
+    }
+
+    // Trim or top up to the density targets for the new size.
+    const size_t ornaments = static_cast<size_t>(OrnamentTarget());
+    if (g_state.ornaments.size() > ornaments) {
+        g_state.ornaments.resize(ornaments);
+        g_state.ornamentOn.resize((ornaments + 63) / 64);
+    }
+    AddOrnaments(static_cast<int>(ornaments) - static_cast<int>(g_state.ornaments.size()));
+
+    const size_t needles = static_cast<size_t>(NeedleTarget());
+    if (g_state.needles.size() > needles) g_state.needles.resize(needles);
+    AddNeedles(static_cast<int>(needles) - static_cast<int>(g_state.needles.size()));
+
+    const size_t flakes = static_cast<size_t>(SnowTarget());
+    if (GpuSnowActive()) {
+        if (g_state.snowSeeds.size() > flakes) g_state.snowSeeds.resize(flakes);
+        AddSnow(static_cast<int>(flakes) - static_cast<int>(g_state.snowSeeds.size()));
+    } else {
+        if (snow.Size() > flakes) snow.Resize(flakes);
+        AddSnow(static_cast<int>(flakes) - static_cast<int>(snow.Size()));
+    }
+}
+
+// Scene files hold these arrays as they are in memory.
+static_assert(std::is_trivially_copyable<TreeLayer>::value && std::is_trivially_copyable<NeedleStroke>::value &&
+                  std::is_trivially_copyable<Ornament>::value,
+              "scene file records must be trivially copyable");
+static_assert(sizeof(Ornament) == 8 && sizeof(NeedleStroke) == 12, "scene records are meant to stay packed");
+
+// Record size of each SceneSection, in section order.
+static const size_t kSceneRecordSizes[kSceneSectionCount] = {
+    sizeof(TreeLayer), sizeof(NeedleStroke), sizeof(Ornament), sizeof(uint64_t), sizeof(float),    sizeof(float),
+    sizeof(float),     sizeof(float),        sizeof(float),    sizeof(uint32_t),
+};
+
+bool SaveScene(const char* path) {
+    XMASS_PROFILE_SCOPE("SaveScene");
+    StageTickState();
+    SceneFileHeader header;
+    header.width = g_state.width;
+    header.height = g_state.height;
+    header.layerCount = g_state.layerCount;
+    header.treeCx = g_state.treeCx;
+    header.treeTopY = g_state.treeTopY;
+    header.treeBottomY = g_state.treeBottomY;
+    header.treeBaseHalfW = g_state.treeBaseHalfW;
+    header.layerHeight = g_state.layerHeight;
+    header.layerOverlap = g_state.layerOverlap;
+    header.blinkPhase = g_state.blinkPhase;
+    header.snowTick = g_state.snowTick;
+    g_state.rng.GetState(header.rng);
+
+    const SnowField& snow = g_state.snow;
+    const void* arrays[kSceneSectionCount] = {
+        g_state.layers.data(), g_state.needles.data(), g_state.ornaments.data(), g_state.ornamentOn.data(),
+        snow.x.data(),         snow.y.data(),          snow.speed.data(),        snow.drift.data(),
+        snow.radius.data(),    g_state.snowSeeds.data(),
+    };
+    const size_t counts[kSceneSectionCount] = {
+        g_state.layers.size(), g_state.needles.size(), g_state.ornaments.size(), g_state.ornamentOn.size(),
+        snow.Size(),           snow.Size(),            snow.Size(),              snow.Size(),
+        snow.Size(),           g_state.snowSeeds.size(),
+    };
+    SceneSectionData sections[kSceneSectionCount];
+    for (size_t i = 0; i < kSceneSectionCount; ++i) {
+        sections[i] = {arrays[i], counts[i], kSceneRecordSizes[i]};
+    }
+    if (!WriteSceneFile(path, header, sections)) {
+        std::fprintf(stderr, "scene: cannot write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+static void CopySection(const SceneFileReader& file, SceneSection section, std::vector<T>& out) {
+    const T* data = static_cast<const T*>(file.Section(section));
+    out.assign(data, data + file.Count(section));
+}
+
+static bool InRange(float v, float lo, float hi) {
+    return std::isfinite(v) && v >= lo && v <= hi;
+}
+
+bool LoadScene(const char* path) {
+    XMASS_PROFILE_SCOPE("LoadScene");
+    SceneFileReader file;
+    if (!file.Open(path, kSceneRecordSizes)) {
+        std::fprintf(stderr, "scene: %s: %s\n", path, file.Error());
+        return false;
+    }
+    const SceneFileHeader& header = file.Header();
+    const size_t flakes = file.Count(SceneSection::SnowX);
+    bool consistent = header.width >= 200 && header.height >= 200 && header.layerCount > 0 &&
+                      file.Count(SceneSection::Layers) == static_cast<size_t>(header.layerCount) &&
+                      file.Count(SceneSection::OrnamentOn) == (file.Count(SceneSection::Ornaments) + 63) / 64;
+    for (SceneSection section : {SceneSection::SnowY, SceneSection::SnowSpeed, SceneSection::SnowDrift, SceneSection::SnowRadius}) {
+        consistent = consistent && file.Count(section) == flakes;
+    }
+    // The header floats size TreeProfile's rows and the layer loops, so
+    // they must describe a tree that fits the window.
+    const float width = static_cast<float>(header.width);
+    const float height = static_cast<float>(header.height);
+    consistent = consistent && InRange(header.treeCx, 0.0f, width) && InRange(header.treeTopY, 0.0f, height) &&
+                 InRange(header.treeBottomY, header.treeTopY + 1.0f, height) &&
+                 InRange(header.treeBaseHalfW, 0.0f, width) && InRange(header.layerHeight, 1.0f, height) &&
+                 InRange(header.layerOverlap, 0.0f, header.layerHeight) && InRange(header.blinkPhase, 0.0f, 60.0f) &&
+                 header.blinkPhase < 60.0f && std::isfinite(header.snowTick) && header.snowTick >= 0.0;
+    const TreeLayer* layers = static_cast<const TreeLayer*>(file.Section(SceneSection::Layers));
+    for (size_t i = 0; consistent && i < file.Count(SceneSection::Layers); ++i) {
+        const TreeLayer& layer = layers[i];
+        consistent = InRange(layer.y0, header.treeTopY, header.treeBottomY) &&
+                     InRange(layer.y1, layer.y0, header.treeBottomY) && InRange(layer.halfW, 0.0f, header.treeBaseHalfW);
+    }
+    // Ornament fields index kPalette and the sprite atlas directly.
+    const Ornament* ornaments = static_cast<const Ornament*>(file.Section(SceneSection::Ornaments));
+    for (size_t i = 0; consistent && i < file.Count(SceneSection::Ornaments); ++i) {
+        const Ornament& o = ornaments[i];
+        consistent = o.paletteA < kPalette.size() && o.paletteB < kPalette.size() && o.radius >= kOrnamentMinRadius &&
+                     o.radius <= kOrnamentMaxRadius;
+    }
+    if (!consistent) {
+        std::fprintf(stderr, "scene: %s: inconsistent scene\n", path);
+        return false;
+    }
+
+    g_tickSource = nullptr;
+    g_state.width = header.width;
+    g_state.height = header.height;
+    g_state.layerCount = header.layerCount;
+    g_state.treeCx = header.treeCx;
+    g_state.treeTopY = header.treeTopY;
+    g_state.treeBottomY = header.treeBottomY;
+    g_state.treeBaseHalfW = header.treeBaseHalfW;
+    g_state.layerHeight = header.layerHeight;
+    g_state.layerOverlap = header.layerOverlap;
+    g_state.blinkPhase = header.blinkPhase;
+    g_state.snowTick = header.snowTick;
+    CopySection(file, SceneSection::Layers, g_state.layers);
+    g_state.profile.Build(g_state.layers, g_state.treeTopY, g_state.treeBottomY, kNeedleMinHalfWidth / kNeedleSpread);
+    CopySection(file, SceneSection::Needles, g_state.needles);
+    CopySection(file, SceneSection::Ornaments, g_state.ornaments);
+    CopySection(file, SceneSection::OrnamentOn, g_state.ornamentOn);
+    SnowField& snow = g_state.snow;
+    CopySection(file, SceneSection::SnowX, snow.x);
+    CopySection(file, SceneSection::SnowY, snow.y);
+    CopySection(file, SceneSection::SnowSpeed, snow.speed);
+    CopySection(file, SceneSection::SnowDrift, snow.drift);
+    CopySection(file, SceneSection::SnowRadius, snow.radius);
+    CopySection(file, SceneSection::SnowSeeds, g_state.snowSeeds);
+    g_state.rng.SetState(header.rng);
+    ++g_sceneVersion;
+
+    // A scene saved with the other snow mode has nothing to animate here.
+    if (GpuSnowActive()) {
+        snow.Clear();
+        if (g_state.snowSeeds.empty()) AddSnow(SnowTarget());
+    } else {
+        g_state.snowSeeds.clear();
+        if (snow.Size() == 0) AddSnow(SnowTarget());
+    }
+    return true;
+}
+
+template <typename T>
+static size_t ArrayBytes(const std::vector<T>& v) {
+    return v.size() * sizeof(T);
+}
+
+size_t SceneMemoryBytes() {
+    const SnowField& snow = g_state.snow;
+    size_t bytes = ArrayBytes(g_state.layers) + ArrayBytes(g_state.needles) + ArrayBytes(g_state.ornaments) +
+                   ArrayBytes(g_state.ornamentOn) + ArrayBytes(snow.x) + ArrayBytes(snow.y) + ArrayBytes(snow.speed) + ArrayBytes(snow.drift) +
+                   ArrayBytes(snow.radius) + ArrayBytes(g_state.snowSeeds);
+    if (g_geometry) {
+        bytes += ArrayBytes(g_geometry->layers) + ArrayBytes(g_geometry->needles) + ArrayBytes(g_geometry->ornaments) +
+                 ArrayBytes(g_geometry->snowSeeds);
+    }
+    return bytes;
+}
+
+static void DrawCircle(float cx, float cy, float r, const Color& c) {
+    if (SoftRasterizer* soft = g_batch.SoftwareTarget()) {
+        g_batch.Flush();
+        soft->Circle(cx, cy, r, c);
+        return;
+    }
+    if (g_sdf.Ready()) {
+        g_sdf.Circle(cx, cy, r, c);
+        return;
+    }
+    const CircleLod& lod = CircleLodForRadius(r);
+    uint32_t center = g_batch.Vertex(cx, cy, c);
+    uint32_t first = g_batch.Vertex(cx + lod.xy[0] * r, cy + lod.xy[1] * r, c);
+    uint32_t prev = first;
+    for (int i = 1; i < lod.segments; ++i) {
+        uint32_t cur = g_batch.Vertex(cx + lod.xy[2 * i] * r, cy + lod.xy[2 * i + 1] * r, c);
+        g_batch.TriangleIndices(center, prev, cur);
+        prev = cur;
+    }
+    g_batch.TriangleIndices(center, prev, first);
+}
+
+static void DrawStar(float cx, float cy, float rOuter, float rInner, const Color& c) {
+    if (g_sdf.Ready()) {
+        g_sdf.Star(cx, cy, rOuter, rInner, c);
+        return;
+    }
+    uint32_t center = g_batch.Vertex(cx, cy, c);
+    std::array<uint32_t, 10> pts{};
+    for (size_t i = 0; i < pts.size(); ++i) {
+        float r = (i % 2 == 0) ? rOuter : rInner;
+        pts[i] = g_batch.Vertex(cx + kStarTable[2 * i] * r, cy + kStarTable[2 * i + 1] * r, c);
+    }
+
+    for (size_t i = 0; i < pts.size(); ++i) {
+        g_batch.TriangleIndices(center, pts[i], pts[(i + 1) % pts.size()]);
+    }
+}
+
+static void DrawSolidTriangle(float x0, float y0, float x1, float y1, float x2, float y2, const Color& c) {
+    if (g_sdf.Ready()) {
+        g_sdf.Triangle(x0, y0, c, x1, y1, c, x2, y2, c);
+        return;
+    }
+    g_batch.Triangle(x0, y0, x1, y1, x2, y2, c);
+}
+
+static void DrawTriangleGradient(float x0, float y0, float x1, float y1, float x2, float y2, const Color& c0, const Color& c1, const Color& c2) {
+    if (g_sdf.Ready()) {
+        g_sdf.Triangle(x0, y0, c0, x1, y1, c1, x2, y2, c2);
+        return;
+    }
+    g_batch.Triangle(x0, y0, c0, x1, y1, c1, x2, y2, c2);
+}
+
+static void DrawLine(float x0, float y0, float x1, float y1, float width, const Color& c) {
+    if (g_sdf.Ready()) {
+        g_sdf.Segment(x0, y0, x1, y1, width * 0.5f, c, c);
+        return;
+    }
+    g_batch.SetLineWidth(width);
+    g_batch.Line(x0, y0, x1, y1, c);
+}
+
+// The core backend hands the NeedleStroke array to g_needleRenderer as it
+// is, flushing what is queued first to keep the painter's order. The
+// legacy and software backends decode each needle into a line.
+static void DrawNeedles(const SceneGeometry& geo) {
+    SCENE_GPU_PASS("DrawNeedles");
+    if (g_needleRenderer.Ready() && !g_batch.SoftwareTarget()) {
+        FlushShapes();
+        g_needleRenderer.Draw(geo.needles.data(), geo.needles.size(), geo.width, geo.height);
+        return;
+    }
+    for (const NeedleStroke& n : geo.needles) {
+        const float x = FromUnit16(n.x, geo.width);
+        const float y = FromUnit16(n.y, geo.height);
+        DrawLine(x, y, x + n.dx / 16.0f, y + n.dy / 16.0f, 1.0f, UnpackColor(n.c));
+    }
+}
+
+static void DrawLayerGarland(const SceneGeometry& geo, float blinkPhase, int layerIndex, float y0, float y1, float halfW) {
+    float garlandY = y0 + (y1 - y0) * 0.72f;
+    float t = (garlandY - y0) / std::max(1.0f, (y1 - y0));
+    float garlandHalfW = t * halfW;
+    int segments = ClampInt(static_cast<int>(halfW / 10.0f), 18, 32);
+    std::array<std::pair<float, float>, 40> pts{};
+
+    float phase = blinkPhase * 0.10f + layerIndex * 0.6f;
+    for (int i = 0; i <= segments; ++i) {
+        float u = static_cast<float>(i) / segments;
+        float x = geo.treeCx - garlandHalfW + u * garlandHalfW * 2.0f;
+        float wave = std::sin(u * 3.1415926f * 2.0f + phase) * (geo.layerHeight * 0.10f);
+        pts[static_cast<size_t>(i)] = {x, garlandY + wave};
+    }
+
+    Color garlandColor = FromRGB(255, 210, 80);
+    garlandColor.a = 0.9f;
+    for (int i = 1; i <= segments; ++i) {
+        auto a = pts[static_cast<size_t>(i - 1)];
+        auto b = pts[static_cast<size_t>(i)];
+        DrawLine(a.first, a.second, b.first, b.second, 2.0f, garlandColor);
+    }
+
+    for (int i = 0; i <= segments; i += 3) {
+        auto p = pts[static_cast<size_t>(i)];
+        float r = 2.7f + (i % 2);
+        bool on = ((static_cast<int>(blinkPhase) / 6 + i + layerIndex * 2) % 2) == 0;
+        Color bead = on ? FromRGB(255, 80, 80) : FromRGB(240, 240, 255);
+        bead.a = on ? 1.0f : 0.9f;
+        DrawCircle(p.first, p.second, r, bead);
+    }
+}
+
+static void DrawTreeStatic(const SceneGeometry& geo) {
+    XMASS_PROFILE_SCOPE("DrawTree");
+    const float cx = geo.treeCx;
+    const float topY = geo.treeTopY;
+    const float bottomY = geo.treeBottomY;
+
+    Color baseGreen = FromRGB(8, 120, 45);
+    Color outline = FromRGB(5, 80, 30, 0.55f);
+
+    // soft shadow behind the tree
+    {
+        SCENE_GPU_PASS("TreeShadow");
+        Color shadow = FromRGB(0, 0, 0, 0.16f);
+        for (int i = geo.layerCount - 1; i >= 0; --i) {
+            const auto& layer = geo.layers[static_cast<size_t>(i)];
+            float y0 = layer.y0 + 5.0f;
+            float y1 = layer.y1 + 5.0f;
+            float hw = layer.halfW + 5.0f;
+            DrawSolidTriangle(cx, y0, cx - hw, y1, cx + hw, y1, shadow);
+        }
+    }
+
+    {
+        SCENE_GPU_PASS("TreeLayers");
+        // trunk behind branches
+        float trunkW = geo.treeBaseHalfW * 0.28f;
+        float trunkH = (bottomY - topY) * 0.18f;
+        float trunkTop = bottomY - trunkH * 0.15f;
+        Color trunkTopC = FromRGB(150, 88, 38);
+        Color trunkBottomC = FromRGB(92, 48, 18);
+        if (g_sdf.Ready()) {
+            // One shape, so the two halves do not leave a seam along the
+            // diagonal.
+            g_sdf.Segment(cx, trunkTop, cx, trunkTop + trunkH, trunkW / 2.0f, trunkTopC, trunkBottomC);
+        } else {
+            uint32_t tl = g_batch.Vertex(cx - trunkW / 2.0f, trunkTop, trunkTopC);
+            uint32_t tr = g_batch.Vertex(cx + trunkW / 2.0f, trunkTop, trunkTopC);
+            uint32_t br = g_batch.Vertex(cx + trunkW / 2.0f, trunkTop + trunkH, trunkBottomC);
+            uint32_t bl = g_batch.Vertex(cx - trunkW / 2.0f, trunkTop + trunkH, trunkBottomC);
+            g_batch.TriangleIndices(tl, tr, br);
+            g_batch.TriangleIndices(tl, br, bl);
+        }
+
+        // layers from bottom -> top for correct overlap
+        for (int i = geo.layerCount - 1; i >= 0; --i) {
+            const auto& layer = geo.layers[static_cast<size_t>(i)];
+            float y0 = layer.y0;
+            float y1 = layer.y1;
+            float hw = layer.halfW;
+
+            float x0 = cx;
+            float x1 = cx - hw;
+            float x2 = cx + hw;
+
+            Color topC = AdjustColor(baseGreen, 40 - i * 4);
+            Color bottomC = AdjustColor(baseGreen, -18 - i * 3);
+
+            DrawTriangleGradient(x0, y0, x1, y1, x2, y1, topC, bottomC, bottomC);
+
+            // subtle depth: darker underside near the bottom edge
+            float shadeH = std::max(10.0f, geo.layerHeight * 0.28f);
+            Color underside = FromRGB(0, 0, 0, 0.08f);
+            DrawSolidTriangle(x0, y1 - shadeH * 0.55f, x1, y1, x2, y1, underside);
+
+            // inner sheen to make it feel less flat
+            Color sheen = AdjustColor(topC, 50);
+            sheen.a = 0.10f;
+            float innerScale = 0.55f;
+            DrawTriangleGradient(
+                x0,
+                y0 + geo.layerHeight * 0.10f,
+                cx - hw * innerScale,
+                y1 - geo.layerHeight * 0.15f,
+                cx + hw * innerScale,
+                y1 - geo.layerHeight * 0.15f,
+                sheen,
+                sheen,
+                sheen);
+
+            // branch fringe along the bottom edge for a more realistic silhouette
+            int fringeCount = ClampInt(static_cast<int>(hw / 12.0f), 10, 26);
+            float fringeAmp = std::max(8.0f, geo.layerHeight * 0.22f);
+            for (int j = 0; j < fringeCount; ++j) {
+                float u0 = static_cast<float>(j) / fringeCount;
+                float u2 = static_cast<float>(j + 1) / fringeCount;
+                float u1 = (u0 + u2) * 0.5f;
+                float bx0 = cx - hw + u0 * hw * 2.0f;
+                float bx2 = cx - hw + u2 * hw * 2.0f;
+                float bxc = cx - hw + u1 * hw * 2.0f;
+                float baseY = y1 - 1.0f;
+                float wobble = std::sin((u1 * 3.1415926f * 2.0f) + i * 0.8f) * (fringeAmp * 0.18f);
+                float tipY = y1 + fringeAmp * (0.55f + 0.45f * std::sin(j * 0.9f + i * 0.7f)) + wobble;
+                Color fringe = AdjustColor(bottomC, -10);
+                fringe.a = 0.96f;
+                DrawSolidTriangle(bx0, baseY, bxc, tipY, bx2, baseY, fringe);
+            }
+
+            // outline and highlights
+            DrawLine(x1, y1, x0, y0, 2.0f, outline);
+            DrawLine(x0, y0, x2, y1, 2.0f, outline);
+
+            Color highlight = AdjustColor(baseGreen, 85);
+            highlight.a = 0.60f;
+            DrawLine(x0, y0, x1 + hw * 0.12f, y1 - geo.layerHeight * 0.08f, 2.0f, highlight);
+            DrawLine(x0, y0, x2 - hw * 0.12f, y1 - geo.layerHeight * 0.08f, 2.0f, highlight);
+        }
+    }
+
+    DrawNeedles(geo);
+
+    // star + glow
+    SCENE_GPU_PASS("TreeStar");
+    float starY = topY - geo.height * 0.03f;
+    float outer = geo.width * 0.040f;
+    float inner = geo.width * 0.019f;
+    Color glow = AdjustColor(FromRGB(255, 220, 70), 25);
+    glow.a = 0.40f;
+    DrawStar(cx, starY, outer + 6.0f, inner + 3.0f, glow);
+
+    Color star = FromRGB(255, 215, 60);
+    DrawStar(cx, starY, outer, inner, star);
+}
+
+static void DrawGarlands(const SceneSnapshot& s, float blend) {
+    SCENE_GPU_PASS("DrawGarlands");
+    const SceneGeometry& geo = *s.geometry;
+    float blinkPhase = s.blinkPhase - s.step * (1.0f - blend);
+    if (blinkPhase < 0.0f) blinkPhase += 60.0f;
+    for (int i = geo.layerCount - 1; i >= 0; --i) {
+        const auto& layer = geo.layers[static_cast<size_t>(i)];
+        DrawLayerGarland(geo, blinkPhase, i, layer.y0, layer.y1, layer.halfW);
+    }
+}
+
+static void SetupProjection(int w, int h) {
+    glViewport(0, 0, w, h);
+    if (g_gl.coreProfile) return;
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, w, h, 0, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+// Everything DrawTreeStatic emits only changes with the geometry, so it is
+// drawn once into g_treeCache and composited as a single quad per frame.
+static void RenderTreeCache(const SceneGeometry& geo, int w, int h) {
+    SCENE_GPU_PASS("RenderTreeCache");
+    g_treeCacheVersion = geo.version;
+    if (g_treeCacheWidth != w || g_treeCacheHeight != h) {
+        g_treeCacheWidth = w;
+        g_treeCacheHeight = h;
+        g_treeCache.Create(w, h, g_sdf.Ready() ? 0 : 4);
+    }
+    if (!g_treeCache.Valid()) return;
+
+    g_treeCache.BeginDraw();
+    SetupProjection(w, h);
+    g_batch.Begin();
+    g_sdf.Begin();
+    g_batch.SetPremultipliedTarget(true);
+    g_sdf.SetPremultipliedTarget(true);
+    g_needleRenderer.SetPremultipliedTarget(true);
+    DrawTreeStatic(geo);
+    FlushShapes();
+    g_batch.SetPremultipliedTarget(false);
+    g_sdf.SetPremultipliedTarget(false);
+    g_needleRenderer.SetPremultipliedTarget(false);
+    SCENE_GPU_PASS("ResolveTreeCache");
+    g_treeCache.EndDraw();
+}
+
+// Ornaments and snow are the bulk of the per-frame geometry. On both GL
+// backends each ornament is one quad from g_ornamentAtlas and snow goes
+// through g_snowRenderer, each as one call; anything already queued is
+// flushed first to keep the painter's order. The software backend draws
+// the ornaments' circles.
+static void DrawOrnaments(const SceneSnapshot& s) {
+    SCENE_GPU_PASS("DrawOrnaments");
+    const SceneGeometry& geo = *s.geometry;
+    const std::vector<Ornament>& ornaments = geo.ornaments;
+    if (g_ornamentAtlas.Ready()) {
+        FlushShapes();
+        g_ornamentAtlas.Begin();
+        for (size_t i = 0; i < ornaments.size(); ++i) {
+            const Ornament& o = ornaments[i];
+            const bool on = ((s.ornamentOn[i / 64] >> (i % 64)) & 1) != 0;
+            g_ornamentAtlas.Add(FromUnit16(o.x, geo.width), FromUnit16(o.y, geo.height), o.radius, on ? o.paletteA : o.paletteB, on);
+        }
+        g_ornamentAtlas.Flush();
+        return;
+    }
+
+    OrnamentLayer layers[4];
+    for (size_t i = 0; i < ornaments.size(); ++i) {
+        const Ornament& o = ornaments[i];
+        const bool on = ((s.ornamentOn[i / 64] >> (i % 64)) & 1) != 0;
+        const float x = FromUnit16(o.x, geo.width);
+        const float y = FromUnit16(o.y, geo.height);
+        const int count = OrnamentLayers(o.radius, kPalette[on ? o.paletteA : o.paletteB], on, layers);
+        for (int l = 0; l < count; ++l) {
+            DrawCircle(x + layers[l].dx, y + layers[l].dy, layers[l].radius, layers[l].c);
+        }
+    }
+}
+
+static void DrawSnow(const SceneSnapshot& s, float blend) {
+    SCENE_GPU_PASS("DrawSnow");
+    Color small = FromRGB(255, 255, 255, 0.95f);
+    Color large = FromRGB(230, 240, 255, 0.95f);
+    const SceneGeometry& geo = *s.geometry;
+    if (GpuSnowActive()) {
+        FlushShapes();
+        if (g_gpuSnowVersion != geo.version) {
+            g_gpuSnow.Upload(geo.snowSeeds);
+            g_gpuSnowVersion = geo.version;
+        }
+        const double tick = s.snowTick - s.step * (1.0 - blend);
+        g_gpuSnow.Draw(tick, static_cast<float>(geo.width), static_cast<float>(geo.height), small, large);
+        return;
+    }
+
+    const size_t count = s.snowX.size();
+    // `blend` shows the state this many steps before the snapshot's, found
+    // by moving each flake back along its velocity.
+    const float stepBack = s.step * (1.0f - blend);
+    if (g_snowRenderer.Ready()) {
+        FlushShapes();
+        if (g_snowRendererVersion != s.snowPropsVersion || g_snowRendererTick != s.snowPropsTick) {
+            g_snowRenderer.Upload(s.snowSpeed.data(), s.snowDrift.data(), s.snowRadius.data(), count);
+            g_snowRendererVersion = s.snowPropsVersion;
+            g_snowRendererTick = s.snowPropsTick;
+        }
+        g_snowRenderer.Draw(s.snowX.data(), s.snowY.data(), count, stepBack, small, large);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const float x = s.snowX[i] - s.snowDrift[i] * stepBack;
+        const float y = s.snowY[i] - s.snowSpeed[i] * stepBack;
+        DrawCircle(x, y, s.snowRadius[i], s.snowRadius[i] >= 3.0f ? large : small);
+    }
+}
+
+void UpdateAnimationStep() {
+    XMASS_PROFILE_SCOPE("UpdateAnimationStep");
+    const float step = g_sceneOptions.simStep;
+    // The tick reads the current state wherever it is and writes the next
+    // one straight into the slot PublishSnapshot hands over next. That is
+    // the source itself after a tick that was not published yet.
+    SceneSnapshot& out = g_snapshots.WriteSlot();
+    if (g_tickSource != &out) {
+        const std::vector<uint64_t>& ornamentOn = g_tickSource ? g_tickSource->ornamentOn : g_state.ornamentOn;
+        out.ornamentOn.assign(ornamentOn.begin(), ornamentOn.end());
+    }
+
+    // Ornaments flip every 10 steps, so a long tick may cross a boundary
+    // anywhere inside it.
+    const float before = g_state.blinkPhase;
+    float after = before + step;
+    int flips = static_cast<int>(after / 10.0f) - static_cast<int>(before / 10.0f);
+    if (after >= 60.0f) after -= 60.0f;
+    g_state.blinkPhase = after;
+    for (; flips > 0; --flips) {
+        // Each ornament flips with probability 1/3; one mask covers 64.
+        for (uint64_t& word : out.ornamentOn) {
+            word ^= g_state.rng.BernoulliMask(1.0 / 3.0);
+        }
+    }
+
+    // Sizes only change with scene edits, so this allocates nothing once
+    // every slot has been through a tick.
+    SnowField& snow = g_state.snow;
+    const size_t n = snow.Size();
+    out.snowX.resize(n);
+    out.snowY.resize(n);
+    const float* x = g_tickSource ? g_tickSource->snowX.data() : snow.x.data();
+    const float* y = g_tickSource ? g_tickSource->snowY.data() : snow.y.data();
+    float* outX = out.snowX.data();
+    float* outY = out.snowY.data();
+    g_tickSource = &out;
+
+    g_state.snowTick += step;
+    if (GpuSnowActive()) {
+        return;
+    }
+
+    // Large budgets are split across the pool. The chunks' RNG streams are
+    // seeded from one draw per tick, so the scene RNG alone decides the
+    // outcome, whatever the worker count.
+    const float width = static_cast<float>(g_state.width);
+    const float height = static_cast<float>(g_state.height);
+    if (n >= 2 * kSnowChunk) {
+        StepSnowParallel(snow, x, y, outX, outY, width, height, step, g_simPool, g_state.rng.Next());
+    } else {
+        // Integrate and wrap in the SIMD kernel, then re-seed the flakes
+        // that fell out in a scalar pass so the RNG stays off the hot loop.
+        StepSnow(snow, x, y, outX, outY, width, height, step);
+        for (uint32_t i : snow.respawn) {
+            RespawnFlake(snow, outX, outY, i, width, g_state.rng);
+        }
+    }
+    g_respawnHistory[++g_snowTicks % kRespawnHistory].assign(snow.respawn.begin(), snow.respawn.end());
+}
+
+// Brings the slot's speed, drift and size up to g_state.snow's. A slot
+// that missed fewer than kRespawnHistory ticks of this scene only needs
+// the flakes those ticks respawned.
+static void SyncSnowProperties(SceneSnapshot& s) {
+    const SnowField& snow = g_state.snow;
+    if (s.snowPropsVersion != g_sceneVersion || s.snowRadius.size() != snow.Size() ||
+        g_snowTicks - s.snowPropsTick >= kRespawnHistory) {
+        s.snowSpeed.assign(snow.speed.begin(), snow.speed.end());
+        s.snowDrift.assign(snow.drift.begin(), snow.drift.end());
+        s.snowRadius.assign(snow.radius.begin(), snow.radius.end());
+    } else {
+        for (uint64_t t = s.snowPropsTick + 1; t <= g_snowTicks; ++t) {
+            for (uint32_t i : g_respawnHistory[t % kRespawnHistory]) {
+                s.snowSpeed[i] = snow.speed[i];
+                s.snowDrift[i] = snow.drift[i];
+                s.snowRadius[i] = snow.radius[i];
+            }
+        }
+    }
+    s.snowPropsVersion = g_sceneVersion;
+    s.snowPropsTick = g_snowTicks;
+}
+
+void PublishSnapshot(double time) {
+    XMASS_PROFILE_SCOPE("PublishSnapshot");
+    if (!g_geometry || g_geometry->version != g_sceneVersion) {
+        auto geo = std::make_shared<SceneGeometry>();
+        geo->version = g_sceneVersion;
+        geo->width = g_state.width;
+        geo->height = g_state.height;
+        geo->layerCount = g_state.layerCount;
+        geo->treeCx = g_state.treeCx;
+        geo->treeTopY = g_state.treeTopY;
+        geo->treeBottomY = g_state.treeBottomY;
+        geo->treeBaseHalfW = g_state.treeBaseHalfW;
+        geo->layerHeight = g_state.layerHeight;
+        geo->layers = g_state.layers;
+        geo->needles = g_state.needles;
+        geo->ornaments = g_state.ornaments;
+        geo->snowSeeds = g_state.snowSeeds;
+        g_geometry = std::move(geo);
+    }
+
+    SceneSnapshot& s = g_snapshots.WriteSlot();
+    s.geometry = g_geometry;
+    s.time = time;
+    s.step = g_sceneOptions.simStep;
+    s.blinkPhase = g_state.blinkPhase;
+    s.snowTick = g_state.snowTick;
+    // A tick since the last publish has already written its state here.
+    // Otherwise (the first publish, or a second one without a tick in
+    // between) the current state is copied in.
+    if (g_tickSource != &s) {
+        const std::vector<uint64_t>& ornamentOn = g_tickSource ? g_tickSource->ornamentOn : g_state.ornamentOn;
+        const std::vector<float>& x = g_tickSource ? g_tickSource->snowX : g_state.snow.x;
+        const std::vector<float>& y = g_tickSource ? g_tickSource->snowY : g_state.snow.y;
+        s.ornamentOn.assign(ornamentOn.begin(), ornamentOn.end());
+        s.snowX.assign(x.begin(), x.end());
+        s.snowY.assign(y.begin(), y.end());
+    }
+    SyncSnowProperties(s);
+    g_snapshots.Publish();
+    g_tickSource = &s;
+}
+
+bool AcquireSnapshot() {
+    return g_snapshots.Acquire();
+}
+
+double SnapshotTime() {
+    return g_snapshots.ReadSlot().time;
+}
+
+void RenderFrame(int w, int h, float blend) {
+    XMASS_PROFILE_SCOPE("RenderFrame");
+    const SceneSnapshot& s = g_snapshots.ReadSlot();
+    g_gpuProfiler.BeginFrame();
+    glEnable(GL_BLEND);
+    if (s.geometry && (g_treeCacheVersion != s.geometry->version || g_treeCacheWidth != w || g_treeCacheHeight != h)) {
+        RenderTreeCache(*s.geometry, w, h);
+    }
+
+    SetupProjection(w, h);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!s.geometry) {
+        g_gpuProfiler.EndFrame();
+        return;
+    }
+    const SceneGeometry& geo = *s.geometry;
+
+    g_batch.Begin();
+    g_sdf.Begin();
+    if (g_treeCache.Valid()) {
+        SCENE_GPU_PASS("CompositeTree");
+        g_treeCache.Composite();
+    } else {
+        DrawTreeStatic(geo);
+    }
+    DrawGarlands(s, blend);
+    DrawOrnaments(s);
+    DrawSnow(s, blend);
+    if (g_profiler.HudVisible()) {
+        DrawProfilerHud(g_batch, w, h);
+    }
+    {
+        SCENE_GPU_PASS("FlushBatch");
+        FlushShapes();
+    }
+    g_gpuProfiler.EndFrame();
+}
+
+// The software backend mirrors RenderFrame: the static tree is rasterized
+// into g_softTree once per geometry, and each frame starts from a copy of
+// it before garlands, ornaments and snow are drawn on top.
+void RenderFrameSoftware(int w, int h, float blend) {
+    XMASS_PROFILE_SCOPE("RenderFrameSoftware");
+    const SceneSnapshot& s = g_snapshots.ReadSlot();
+    if (!s.geometry) {
+        g_softFrame.Resize(w, h);
+        g_softFrame.Begin(nullptr);
+        g_softFrame.Render(g_pool);
+        return;
+    }
+    const SceneGeometry& geo = *s.geometry;
+    if (g_softTreeVersion != geo.version || g_softTree.Width() != w || g_softTree.Height() != h) {
+        g_softTreeVersion = geo.version;
+        g_softTree.Resize(w, h);
+        g_softTree.Begin(nullptr);
+        g_batch.SetSoftwareTarget(&g_softTree);
+        g_batch.Begin();
+        DrawTreeStatic(geo);
+        g_batch.Flush();
+        XMASS_PROFILE_SCOPE("RasterizeTree");
+        g_softTree.Render(g_pool);
+    }
+
+    g_softFrame.Resize(w, h);
+    g_softFrame.Begin(g_softTree.Pixels());
+    g_batch.SetSoftwareTarget(&g_softFrame);
+    g_batch.Begin();
+    DrawGarlands(s, blend);
+    DrawOrnaments(s);
+    DrawSnow(s, blend);
+    if (g_profiler.HudVisible()) {
+        DrawProfilerHud(g_batch, w, h);
+    }
+    g_batch.Flush();
+    g_batch.SetSoftwareTarget(nullptr);
+    XMASS_PROFILE_SCOPE("Rasterize");
+    g_softFrame.Render(g_pool);
+}
+
+SoftRasterizer& SoftwareFrame() {
+    return g_softFrame;
+}
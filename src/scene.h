@@ -0,0 +1,197 @@
+#pragma once
+
+#include "color.h"
+#include "gl_ext.h"
+#include "rng.h"
+#include "snow_field.h"
+#include "thread_pool.h"
+#include "tree_profile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class SoftRasterizer;
+
+// Ornaments and needles are packed records. Positions are 16-bit fractions
+// of the window size (1/65535 steps, under 0.06 px at 4K), so resizing
+// leaves them alone; sizes and offsets stay in pixels. Whether an ornament
+// is lit lives in a separate bitset (AppState::ornamentOn).
+struct Ornament {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint8_t radius = 6;   // kOrnamentMinRadius..kOrnamentMaxRadius
+    uint8_t paletteA = 0; // kPalette index shown when lit
+    uint8_t paletteB = 0; // ... and when not
+    uint8_t reserved = 0;
+};
+
+struct NeedleStroke {
+    uint16_t x = 0; // start, as Ornament's
+    uint16_t y = 0;
+    int8_t dx = 0;  // to the end, in 1/16 px
+    int8_t dy = 0;
+    uint8_t reserved[2] = {};
+    Rgba8 c{};
+};
+
+// The simulation's working state. Only the thread driving the simulation
+// (SimThread, or the caller in headless runs and benchmarks) touches it;
+// renderers draw from a SceneSnapshot instead. Between scene changes the
+// ticks keep ornamentOn and the snow positions in the snapshots, and the
+// copies here are only brought up to date when the scene is edited or
+// saved.
+struct AppState {
+    int width = 800;
+    int height = 600;
+    float blinkPhase = 0.0f; // [0, 60) in 30 Hz steps
+    double snowTick = 0.0;   // 30 Hz steps since the snow was seeded
+    int layerCount = 6;
+    float treeCx = 400.0f;
+    float treeTopY = 60.0f;
+    float treeBottomY = 480.0f;
+    float treeBaseHalfW = 200.0f;
+    float layerHeight = 80.0f;
+    float layerOverlap = 40.0f;
+    std::vector<TreeLayer> layers;
+    TreeProfile profile;
+    std::vector<NeedleStroke> needles;
+    std::vector<Ornament> ornaments;
+    std::vector<uint64_t> ornamentOn; // bit i: ornaments[i] is lit; later bits are garbage
+    SnowField snow;
+    std::vector<uint32_t> snowSeeds; // --gpu-snow: one seed per flake
+    Rng rng;
+};
+
+// Everything drawn that only changes in RegenerateScene and ResizeScene.
+// Built by PublishSnapshot when the scene changed and immutable afterwards;
+// snapshots share it.
+struct SceneGeometry {
+    uint64_t version = 0;
+    int width = 800;
+    int height = 600;
+    int layerCount = 6;
+    float treeCx = 400.0f;
+    float treeTopY = 60.0f;
+    float treeBottomY = 480.0f;
+    float treeBaseHalfW = 200.0f;
+    float layerHeight = 80.0f;
+    std::vector<TreeLayer> layers;
+    std::vector<NeedleStroke> needles;
+    std::vector<Ornament> ornaments;
+    std::vector<uint32_t> snowSeeds;
+};
+
+// One published simulation state: the geometry it belongs to plus what
+// the ticks change. UpdateAnimationStep writes each tick straight into the
+// slot that is published next, stepping from the last published one, so
+// publishing normally just hands the slot over along with the new speed,
+// drift and size of the flakes that respawned. Slots are recycled, so
+// steady-state ticks do not allocate.
+//
+// Interpolated frames show the state between two ticks by stepping each
+// flake back along its velocity (snowSpeed/snowDrift) rather than keeping
+// the previous positions, so a flake that wrapped or respawned glides in
+// from just outside its new spot instead of streaking across the window.
+struct SceneSnapshot {
+    std::shared_ptr<const SceneGeometry> geometry;
+    double time = 0.0;  // when this state is current, in the publisher's clock
+    float step = 1.0f;  // 30 Hz steps since the previous state
+    float blinkPhase = 0.0f;
+    double snowTick = 0.0;
+    std::vector<uint64_t> ornamentOn; // AppState::ornamentOn
+    std::vector<float> snowX;
+    std::vector<float> snowY;
+    // Re-rolled when a flake respawns. PublishSnapshot only copies the
+    // flakes that changed since the slot's snowPropsTick, so these carry
+    // the scene version and tick they were brought up to.
+    std::vector<float> snowSpeed;
+    std::vector<float> snowDrift;
+    std::vector<float> snowRadius;
+    uint64_t snowPropsVersion = 0;
+    uint64_t snowPropsTick = 0;
+};
+
+struct SceneOptions {
+    int snowBudget = 0;   // 0 sizes the snow to the window
+    int needleBudget = 0; // 0 sizes the needles to the window
+    bool gpuSnow = false;
+    // Animation time per UpdateAnimationStep, in 30 Hz steps: --sim-hz=15
+    // makes it 2, so the scene moves at the same speed with half the ticks.
+    float simStep = 1.0f;
+    // --interpolate: frames are rendered with a blend between the previous
+    // tick and the current one instead of at 1.
+    bool interpolate = false;
+    // --aa=sdf on the core backend: shapes get analytic edge coverage
+    // (SdfRenderer) instead of multisampling and line smoothing, so the
+    // framebuffer and the tree cache can be single-sampled. Read by
+    // InitRenderer.
+    bool sdfAntialias = false;
+};
+
+// The scene is process-wide: main.cpp drives it from the window or the
+// headless loop, and bench/xmass_bench.cpp drives it directly.
+extern AppState g_state;
+extern SceneOptions g_sceneOptions;
+// Started by the caller when needed: g_pool for the software rasterizer,
+// g_simPool for large snow budgets. They are separate because rendering
+// and simulation run on different threads and a pool takes one
+// ParallelFor at a time.
+extern ThreadPool g_pool;
+extern ThreadPool g_simPool;
+
+// Loads GL entry points for the current context and creates the core
+// backend's programs. Not needed for RenderFrameSoftware.
+bool InitRenderer(GLProcLoader loader, bool core);
+void ShutdownRenderer();
+
+// --gpu-snow: the scene keeps one seed per flake instead of a SnowField,
+// and the core backend's vertex shader animates them. The simulation only
+// looks at SceneOptions::gpuSnow, so a scene can be generated before the
+// renderer exists.
+bool GpuSnowActive();
+size_t GpuSnowCount();
+// Once the renderer is up (or known to be software): if --gpu-snow was
+// asked for but the backend cannot animate snow, turns it off and gives an
+// existing scene a CPU snow field instead. Main thread, with the
+// simulation idle.
+void ResolveGpuSnow();
+
+void RegenerateScene(int w, int h);
+// Live-resize path: scales the existing scene to the new size and only
+// trims or tops up ornaments, needles and snow to the density targets, so
+// nothing reshuffles. Callers regenerate once resizing settles.
+void ResizeScene(int w, int h);
+// Scene files (see scene_file.h). SaveScene writes the whole g_state,
+// RNG streams included, so a loaded scene animates exactly as the saved
+// one would have. LoadScene replaces g_state with the file's scene at the
+// size it was saved; callers ResizeScene to their own. Both print why they
+// failed to stderr.
+bool SaveScene(const char* path);
+bool LoadScene(const char* path);
+
+// Bytes of scene data held by the simulation (g_state's arrays) plus the
+// geometry last published from it, for --stats and the benchmarks.
+size_t SceneMemoryBytes();
+// One animation tick of g_sceneOptions.simStep 30 Hz steps: ornament
+// blinking and snow.
+void UpdateAnimationStep();
+
+// Simulation side: hands the current g_state to the renderer, stamped with
+// `time` (see SceneSnapshot::time). Never blocks; a snapshot the renderer
+// has not picked up yet is replaced.
+void PublishSnapshot(double time);
+// Render side: switches to the newest published snapshot. Returns false
+// if nothing was published since the last call.
+bool AcquireSnapshot();
+// SceneSnapshot::time of the snapshot last acquired.
+double SnapshotTime();
+
+// Draw the snapshot last acquired. `blend` in [0, 1] goes from the
+// previous state to the current one; without SceneOptions::interpolate
+// only 1 is meaningful.
+void RenderFrame(int w, int h, float blend);
+// Rasterizes the frame into SoftwareFrame() on g_pool.
+void RenderFrameSoftware(int w, int h, float blend);
+SoftRasterizer& SoftwareFrame();
@@ -0,0 +1,173 @@
+#include "scene_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(SceneSectionEntry) == 24, "scene file layout changed");
+static_assert(sizeof(SceneFileHeader) == 104 + 24 * kSceneSectionCount, "scene file layout changed");
+
+static size_t AlignUp(size_t v) {
+    return (v + kSceneSectionAlignment - 1) & ~(kSceneSectionAlignment - 1);
+}
+
+static bool ReplaceFile(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from, to) == 0;
+#endif
+}
+
+bool WriteSceneFile(const char* path, SceneFileHeader header, const SceneSectionData (&sections)[kSceneSectionCount]) {
+    const SceneFileHeader defaults;
+    std::memcpy(header.magic, defaults.magic, sizeof(header.magic));
+    header.version = kSceneFileVersion;
+    header.byteOrder = kSceneFileByteOrder;
+    size_t offset = AlignUp(sizeof(SceneFileHeader));
+    for (size_t i = 0; i < kSceneSectionCount; ++i) {
+        SceneSectionEntry& entry = header.sections[i];
+        entry = SceneSectionEntry{};
+        entry.recordSize = static_cast<uint32_t>(sections[i].recordSize);
+        entry.count = sections[i].count;
+        if (entry.count == 0) continue;
+        entry.offset = offset;
+        offset = AlignUp(offset + sections[i].count * sections[i].recordSize);
+    }
+    header.fileSize = offset;
+
+    const std::string temp = std::string(path) + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (!file) return false;
+    static const char kZeros[kSceneSectionAlignment] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    size_t written = sizeof(header);
+    for (size_t i = 0; ok && i < kSceneSectionCount; ++i) {
+        const SceneSectionEntry& entry = header.sections[i];
+        if (entry.count == 0) continue;
+        ok = std::fwrite(kZeros, 1, entry.offset - written, file) == entry.offset - written;
+        const size_t bytes = sections[i].count * sections[i].recordSize;
+        ok = ok && std::fwrite(sections[i].data, 1, bytes, file) == bytes;
+        written = entry.offset + bytes;
+    }
+    ok = ok && std::fwrite(kZeros, 1, offset - written, file) == offset - written;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || !ReplaceFile(temp.c_str(), path)) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SceneFileReader::Open(const char* path, const size_t (&recordSizes)[kSceneSectionCount]) {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error_ = "cannot open";
+        return false;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(SceneFileHeader))) {
+        CloseHandle(file);
+        error_ = "not a scene file";
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    data_ = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data_) {
+        Close();
+        error_ = "cannot map";
+        return false;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        error_ = "cannot open";
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SceneFileHeader))) {
+        ::close(fd);
+        error_ = "not a scene file";
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        error_ = "cannot map";
+        return false;
+    }
+    data_ = data;
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+
+    const SceneFileHeader& header = Header();
+    const SceneFileHeader defaults;
+    if (std::memcmp(header.magic, defaults.magic, sizeof(header.magic)) != 0) {
+        error_ = "not a scene file";
+    } else if (header.byteOrder != kSceneFileByteOrder) {
+        error_ = "written on a machine with another byte order";
+    } else if (header.version != kSceneFileVersion) {
+        error_ = "written by another version";
+    } else if (header.fileSize != size_) {
+        error_ = "truncated";
+    } else {
+        error_ = nullptr;
+        for (size_t i = 0; i < kSceneSectionCount && !error_; ++i) {
+            const SceneSectionEntry& entry = header.sections[i];
+            if (entry.recordSize != recordSizes[i]) {
+                error_ = "written by another version";
+            } else if (entry.count == 0) {
+                continue;
+            } else if (entry.offset % kSceneSectionAlignment != 0 || entry.offset < sizeof(SceneFileHeader) || entry.offset > size_ ||
+                       entry.count > (size_ - entry.offset) / entry.recordSize) {
+                error_ = "corrupt section table";
+            }
+        }
+    }
+    if (error_) {
+        const char* error = error_;
+        Close();
+        error_ = error;
+        return false;
+    }
+    error_ = "";
+    return true;
+}
+
+void SceneFileReader::Close() {
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    if (data_) munmap(const_cast<void*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    error_ = "";
+}
+
+const void* SceneFileReader::Section(SceneSection section) const {
+    const SceneSectionEntry& entry = Header().sections[static_cast<size_t>(section)];
+    return entry.count ? static_cast<const char*>(data_) + entry.offset : nullptr;
+}
+
+size_t SceneFileReader::Count(SceneSection section) const {
+    return static_cast<size_t>(Header().sections[static_cast<size_t>(section)].count);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Binary scene files (--scene, --save-scene): a fixed header holding the
+// scalar scene state and a section table, then one array per section in
+// the process's native record layout, each 64-byte aligned. Loading maps
+// the file read-only and checks the header and the table, after which the
+// arrays are read straight out of the mapping with one bulk copy each and
+// no per-record parsing. Every process loading the same file shares its
+// page-cache pages.
+//
+// Records are the in-memory structs, so changing one of them bumps
+// kSceneFileVersion. The header also stores each section's record size and
+// the writer's byte order, and a file that does not match is rejected
+// rather than misread.
+
+constexpr uint32_t kSceneFileVersion = 3;
+constexpr uint32_t kSceneFileByteOrder = 0x01020304;
+constexpr size_t kSceneSectionAlignment = 64;
+
+enum class SceneSection : uint32_t {
+    Layers,     // TreeLayer
+    Needles,    // NeedleStroke
+    Ornaments,  // Ornament
+    OrnamentOn, // uint64_t, AppState::ornamentOn
+    SnowX,      // float, as are the other four SnowField arrays
+    SnowY,
+    SnowSpeed,
+    SnowDrift,
+    SnowRadius,
+    SnowSeeds,  // uint32_t, --gpu-snow
+    Count,
+};
+
+constexpr size_t kSceneSectionCount = static_cast<size_t>(SceneSection::Count);
+
+struct SceneSectionEntry {
+    uint64_t offset = 0; // from the start of the file
+    uint64_t count = 0;  // records
+    uint32_t recordSize = 0;
+    uint32_t reserved = 0;
+};
+
+struct SceneFileHeader {
+    char magic[8] = {'X', 'M', 'S', 'C', 'E', 'N', 'E', '\0'};
+    uint32_t version = kSceneFileVersion;
+    uint32_t byteOrder = kSceneFileByteOrder;
+    uint64_t fileSize = 0;
+    // AppState's scalars.
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t layerCount = 0;
+    float treeCx = 0.0f;
+    float treeTopY = 0.0f;
+    float treeBottomY = 0.0f;
+    float treeBaseHalfW = 0.0f;
+    float layerHeight = 0.0f;
+    float layerOverlap = 0.0f;
+    float blinkPhase = 0.0f;
+    double snowTick = 0.0;
+    uint64_t rng[4] = {};
+    SceneSectionEntry sections[kSceneSectionCount];
+};
+
+// One array to write: `count` records of `recordSize` bytes.
+struct SceneSectionData {
+    const void* data = nullptr;
+    size_t count = 0;
+    size_t recordSize = 0;
+};
+
+// Writes `header` (whose version, byte order, size and section table are
+// filled in here) and the sections to a temporary file next to `path`,
+// then renames it over `path`. Processes that still have the old file
+// mapped keep reading it undisturbed.
+bool WriteSceneFile(const char* path, SceneFileHeader header, const SceneSectionData (&sections)[kSceneSectionCount]);
+
+// A scene file mapped read-only.
+class SceneFileReader {
+public:
+    ~SceneFileReader() { Close(); }
+
+    // Maps `path` and checks the magic, version, byte order, size and that
+    // every section lies inside the file, is aligned and has the record
+    // size given in `recordSizes`. On failure Error() says why.
+    bool Open(const char* path, const size_t (&recordSizes)[kSceneSectionCount]);
+    void Close();
+    const char* Error() const { return error_; }
+
+    const SceneFileHeader& Header() const { return *static_cast<const SceneFileHeader*>(data_); }
+    const void* Section(SceneSection section) const;
+    size_t Count(SceneSection section) const;
+
+private:
+    const void* data_ = nullptr;
+    size_t size_ = 0;
+    const char* error_ = "";
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
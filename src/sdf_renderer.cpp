@@ -0,0 +1,275 @@
+#include "sdf_renderer.h"
+
+#include <algorithm>
+#include <cstddef>
+
+static const char* kSdfVertexShader = R"(#version 330 core
+uniform vec2 uViewport;
+in vec2 aCorner;
+in vec4 aA;
+in vec4 aB;
+in uint aShape;
+in vec4 aC0;
+in vec4 aC1;
+in vec4 aC2;
+out vec2 vPos;
+flat out vec4 vA;
+flat out vec4 vB;
+flat out uint vShape;
+flat out vec4 vC0;
+flat out vec4 vC1;
+flat out vec4 vC2;
+void main() {
+    vec2 lo;
+    vec2 hi;
+    if (aShape == 1u) {
+        lo = min(aA.xy, aA.zw) - aB.x;
+        hi = max(aA.xy, aA.zw) + aB.x;
+    } else if (aShape == 3u) {
+        lo = min(min(aA.xy, aA.zw), aB.xy);
+        hi = max(max(aA.xy, aA.zw), aB.xy);
+    } else {
+        lo = aA.xy - aA.z;
+        hi = aA.xy + aA.z;
+    }
+    // One pixel of margin for the coverage ramp.
+    vPos = mix(lo - 1.0, hi + 1.0, aCorner);
+    vec2 ndc = vPos / uViewport * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    vA = aA;
+    vB = aB;
+    vShape = aShape;
+    vC0 = aC0;
+    vC1 = aC1;
+    vC2 = aC2;
+}
+)";
+
+static const char* kSdfFragmentShader = R"(#version 330 core
+in vec2 vPos;
+flat in vec4 vA;
+flat in vec4 vB;
+flat in uint vShape;
+flat in vec4 vC0;
+flat in vec4 vC1;
+flat in vec4 vC2;
+out vec4 fragColor;
+
+// Box distance in the segment's own frame; t is the position along it.
+float SegmentDistance(vec2 p, vec2 a, vec2 b, float halfWidth, out float t) {
+    vec2 e = b - a;
+    float len = max(length(e), 1e-6);
+    vec2 dir = e / len;
+    vec2 w = p - a;
+    float u = dot(w, dir);
+    float v = dir.x * w.y - dir.y * w.x;
+    t = clamp(u / len, 0.0, 1.0);
+    vec2 q = vec2(abs(u - 0.5 * len) - 0.5 * len, abs(v) - halfWidth);
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);
+}
+
+// Folds p into the wedge between an inner corner (on the x axis) and the
+// next tip, then measures to the edge joining them.
+float StarDistance(vec2 p, float outer, float inner) {
+    const float an = 3.14159265 / 5.0;
+    p.y = -p.y; // window y points down; the top tip is +y here
+    float bn = mod(atan(p.x, p.y), 2.0 * an) - an;
+    p = length(p) * vec2(cos(bn), abs(sin(bn)));
+    vec2 tip = outer * vec2(cos(an), sin(an));
+    vec2 e = vec2(inner, 0.0) - tip;
+    vec2 w = p - tip;
+    float dist = length(w - e * clamp(dot(w, e) / dot(e, e), 0.0, 1.0));
+    return (e.x * w.y - e.y * w.x) < 0.0 ? -dist : dist;
+}
+
+float TriangleDistance(vec2 p, vec2 p0, vec2 p1, vec2 p2) {
+    vec2 e0 = p1 - p0;
+    vec2 e1 = p2 - p1;
+    vec2 e2 = p0 - p2;
+    vec2 v0 = p - p0;
+    vec2 v1 = p - p1;
+    vec2 v2 = p - p2;
+    vec2 pq0 = v0 - e0 * clamp(dot(v0, e0) / max(dot(e0, e0), 1e-12), 0.0, 1.0);
+    vec2 pq1 = v1 - e1 * clamp(dot(v1, e1) / max(dot(e1, e1), 1e-12), 0.0, 1.0);
+    vec2 pq2 = v2 - e2 * clamp(dot(v2, e2) / max(dot(e2, e2), 1e-12), 0.0, 1.0);
+    float s = sign(e0.x * e2.y - e0.y * e2.x);
+    vec2 d = min(min(vec2(dot(pq0, pq0), s * (v0.x * e0.y - v0.y * e0.x)),
+                     vec2(dot(pq1, pq1), s * (v1.x * e1.y - v1.y * e1.x))),
+                 vec2(dot(pq2, pq2), s * (v2.x * e2.y - v2.y * e2.x)));
+    return -sqrt(d.x) * sign(d.y);
+}
+
+// Clamped to the triangle so the edge ramp keeps the edge's color.
+vec3 Barycentric(vec2 p, vec2 a, vec2 b, vec2 c) {
+    vec2 v0 = b - a;
+    vec2 v1 = c - a;
+    vec2 v2 = p - a;
+    float den = v0.x * v1.y - v1.x * v0.y;
+    float v = (v2.x * v1.y - v1.x * v2.y) / den;
+    float w = (v0.x * v2.y - v2.x * v0.y) / den;
+    vec3 bc = clamp(vec3(1.0 - v - w, v, w), 0.0, 1.0);
+    return bc / (bc.x + bc.y + bc.z);
+}
+
+void main() {
+    float d;
+    vec4 color = vC0;
+    if (vShape == 0u) {
+        d = length(vPos - vA.xy) - vA.z;
+    } else if (vShape == 1u) {
+        float t;
+        d = SegmentDistance(vPos, vA.xy, vA.zw, vB.x, t);
+        color = mix(vC0, vC1, t);
+    } else if (vShape == 2u) {
+        d = StarDistance(vPos - vA.xy, vA.z, vA.w);
+    } else {
+        vec2 e0 = vA.zw - vA.xy;
+        vec2 e1 = vB.xy - vA.xy;
+        if (e0.x * e1.y - e0.y * e1.x == 0.0) discard;
+        d = TriangleDistance(vPos, vA.xy, vA.zw, vB.xy);
+        vec3 w = Barycentric(vPos, vA.xy, vA.zw, vB.xy);
+        color = vC0 * w.x + vC1 * w.y + vC2 * w.z;
+    }
+    // Box-filtered edge: the fraction of a one-pixel footprint inside.
+    float coverage = clamp(0.5 - d, 0.0, 1.0);
+    if (coverage <= 0.0) discard;
+    fragColor = vec4(color.rgb, color.a * coverage);
+}
+)";
+
+static void ToBytes(const Color& c, uint8_t* out) {
+    out[0] = ToByte(c.r);
+    out[1] = ToByte(c.g);
+    out[2] = ToByte(c.b);
+    out[3] = ToByte(c.a);
+}
+
+bool SdfRenderer::Init() {
+    const char* attributes[] = {"aCorner", "aA", "aB", "aShape", "aC0", "aC1", "aC2"};
+    program_ = BuildProgram(kSdfVertexShader, kSdfFragmentShader, attributes, 7);
+    if (!program_) {
+        return false;
+    }
+    viewportLoc_ = g_gl.GetUniformLocation(program_, "uViewport");
+
+    const float corners[] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f};
+    g_gl.GenVertexArrays(1, &vao_);
+    g_gl.GenBuffers(1, &meshVbo_);
+    g_gl.GenBuffers(1, &instanceVbo_);
+    g_gl.BindVertexArray(vao_);
+
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, meshVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    g_gl.EnableVertexAttribArray(0);
+    g_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    const GLsizei stride = sizeof(SdfInstance);
+    g_gl.EnableVertexAttribArray(1);
+    g_gl.VertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, a)));
+    g_gl.EnableVertexAttribArray(2);
+    g_gl.VertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, b)));
+    g_gl.EnableVertexAttribArray(3);
+    g_gl.VertexAttribIPointer(3, 1, GL_UNSIGNED_INT, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, shape)));
+    g_gl.EnableVertexAttribArray(4);
+    g_gl.VertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, c0)));
+    g_gl.EnableVertexAttribArray(5);
+    g_gl.VertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, c1)));
+    g_gl.EnableVertexAttribArray(6);
+    g_gl.VertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, c2)));
+    for (GLuint attr = 1; attr <= 6; ++attr) {
+        g_gl.VertexAttribDivisor(attr, 1);
+    }
+
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void SdfRenderer::Destroy() {
+    if (instanceVbo_) g_gl.DeleteBuffers(1, &instanceVbo_);
+    if (meshVbo_) g_gl.DeleteBuffers(1, &meshVbo_);
+    if (vao_) g_gl.DeleteVertexArrays(1, &vao_);
+    if (program_) g_gl.DeleteProgram(program_);
+    instanceVbo_ = 0;
+    meshVbo_ = 0;
+    vao_ = 0;
+    program_ = 0;
+    instances_.clear();
+}
+
+void SdfRenderer::Circle(float cx, float cy, float r, const Color& c) {
+    SdfInstance inst;
+    inst.shape = SdfShape::Circle;
+    inst.a[0] = cx;
+    inst.a[1] = cy;
+    inst.a[2] = r;
+    ToBytes(c, inst.c0);
+    instances_.push_back(inst);
+}
+
+void SdfRenderer::Segment(float x0, float y0, float x1, float y1, float halfWidth, const Color& c0, const Color& c1) {
+    SdfInstance inst;
+    inst.shape = SdfShape::Segment;
+    inst.a[0] = x0;
+    inst.a[1] = y0;
+    inst.a[2] = x1;
+    inst.a[3] = y1;
+    inst.b[0] = halfWidth;
+    ToBytes(c0, inst.c0);
+    ToBytes(c1, inst.c1);
+    instances_.push_back(inst);
+}
+
+void SdfRenderer::Star(float cx, float cy, float rOuter, float rInner, const Color& c) {
+    SdfInstance inst;
+    inst.shape = SdfShape::Star;
+    inst.a[0] = cx;
+    inst.a[1] = cy;
+    inst.a[2] = rOuter;
+    inst.a[3] = rInner;
+    ToBytes(c, inst.c0);
+    instances_.push_back(inst);
+}
+
+void SdfRenderer::Triangle(float x0, float y0, const Color& c0, float x1, float y1, const Color& c1, float x2, float y2, const Color& c2) {
+    SdfInstance inst;
+    inst.shape = SdfShape::Triangle;
+    inst.a[0] = x0;
+    inst.a[1] = y0;
+    inst.a[2] = x1;
+    inst.a[3] = y1;
+    inst.b[0] = x2;
+    inst.b[1] = y2;
+    ToBytes(c0, inst.c0);
+    ToBytes(c1, inst.c1);
+    ToBytes(c2, inst.c2);
+    instances_.push_back(inst);
+}
+
+void SdfRenderer::Flush() {
+    if (instances_.empty() || !program_) {
+        instances_.clear();
+        return;
+    }
+
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    if (premultipliedTarget_ && g_gl.BlendFuncSeparate) {
+        g_gl.BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    g_gl.UseProgram(program_);
+    g_gl.Uniform2f(viewportLoc_, static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(instances_.size() * sizeof(SdfInstance)), instances_.data(), GL_STREAM_DRAW);
+    g_gl.DrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, static_cast<GLsizei>(instances_.size()));
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    g_gl.UseProgram(0);
+
+    instances_.clear();
+}
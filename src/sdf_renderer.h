@@ -0,0 +1,57 @@
+#pragma once
+
+#include "color.h"
+#include "gl_ext.h"
+
+#include <cstdint>
+#include <vector>
+
+enum class SdfShape : uint32_t {
+    Circle,   // a = center, radius
+    Segment,  // a = endpoints, b.x = half width; butt ends like the batch's line quads
+    Star,     // a = center, outer and inner radius; five tips, one pointing up
+    Triangle, // a = first two corners, b.xy = third
+};
+
+struct SdfInstance {
+    float a[4] = {};
+    float b[4] = {};
+    SdfShape shape = SdfShape::Circle;
+    // Triangles blend the three by barycentric weight, segments run from
+    // c0 at the first endpoint to c1; everything else is c0.
+    uint8_t c0[4] = {0, 0, 0, 255};
+    uint8_t c1[4] = {0, 0, 0, 255};
+    uint8_t c2[4] = {0, 0, 0, 255};
+};
+
+// Core-profile only. Anti-aliasing without multisampling: every shape is
+// one instanced quad covering its bounds plus a pixel, and the fragment
+// shader evaluates the shape's exact signed distance and turns it into
+// coverage over a one-pixel ramp. Shapes are drawn in the order they were
+// added, in one draw call per Flush, so the framebuffer and the tree cache
+// can both be single-sampled and GL_LINE_SMOOTH is not needed.
+class SdfRenderer {
+public:
+    bool Init();
+    void Destroy();
+    bool Ready() const { return program_ != 0; }
+
+    // As BatchRenderer::SetPremultipliedTarget.
+    void SetPremultipliedTarget(bool enabled) { premultipliedTarget_ = enabled; }
+
+    void Begin() { instances_.clear(); }
+    void Circle(float cx, float cy, float r, const Color& c);
+    void Segment(float x0, float y0, float x1, float y1, float halfWidth, const Color& c0, const Color& c1);
+    void Star(float cx, float cy, float rOuter, float rInner, const Color& c);
+    void Triangle(float x0, float y0, const Color& c0, float x1, float y1, const Color& c1, float x2, float y2, const Color& c2);
+    void Flush();
+
+private:
+    std::vector<SdfInstance> instances_;
+    bool premultipliedTarget_ = false;
+    GLuint program_ = 0;
+    GLint viewportLoc_ = -1;
+    GLuint vao_ = 0;
+    GLuint meshVbo_ = 0;
+    GLuint instanceVbo_ = 0;
+};
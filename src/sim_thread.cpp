@@ -0,0 +1,161 @@
+#include "sim_thread.h"
+
+#include "scene.h"
+
+#include <algorithm>
+
+// A thread that falls further behind than this (e.g. after a suspend)
+// drops the backlog instead of replaying it in one burst.
+static constexpr int kMaxCatchUpTicks = 5;
+
+static std::chrono::steady_clock::duration Seconds(double seconds) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+void SimThread::Start(double tickInterval, void (*onPublish)()) {
+    Stop();
+    tickInterval_ = Seconds(tickInterval);
+    onPublish_ = onPublish;
+    stopping_ = false;
+    paused_ = false;
+    settleAt_ = Clock::time_point{};
+    startTime_ = Clock::now();
+    ticks_ = 0;
+    snapshots_ = 0;
+    commandCount_ = 0;
+    dropped_ = 0;
+    busyNs_ = 0;
+    thread_ = std::thread(&SimThread::Main, this);
+}
+
+void SimThread::Stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(wakeLock_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void SimThread::SetPaused(bool paused) {
+    {
+        std::lock_guard<std::mutex> guard(wakeLock_);
+        paused_ = paused;
+    }
+    wake_.notify_all();
+}
+
+bool SimThread::Post(const SimCommand& command) {
+    if (!commands_.TryPush(command)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // Wakes the thread early so a resize is not held until the next tick.
+    // Notifying without the lock never blocks; a wake-up lost to the race
+    // only delays the command to the next tick.
+    wake_.notify_one();
+    return true;
+}
+
+bool SimThread::ApplyCommands(Clock::time_point now) {
+    bool changed = false;
+    bool resize = false;
+    SimCommand command;
+    while (commands_.TryPop(command)) {
+        commandCount_.fetch_add(1, std::memory_order_relaxed);
+        if (command.type == SimCommand::Type::Regenerate) {
+            RegenerateScene(command.width, command.height);
+            resize = false;
+            settleAt_ = Clock::time_point{};
+            changed = true;
+        } else if (command.type == SimCommand::Type::Save) {
+            if (SaveScene(command.path)) {
+                std::printf("scene: saved %s\n", command.path);
+            }
+        } else {
+            resize = true;
+            resizeWidth_ = command.width;
+            resizeHeight_ = command.height;
+        }
+    }
+
+    if (resize) {
+        ResizeScene(resizeWidth_, resizeHeight_);
+        settleAt_ = now + Seconds(kResizeSettleSeconds);
+        changed = true;
+    } else if (settleAt_ != Clock::time_point{} && now >= settleAt_) {
+        RegenerateScene(resizeWidth_, resizeHeight_);
+        settleAt_ = Clock::time_point{};
+        changed = true;
+    }
+    return changed;
+}
+
+static double Stamp(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double>(t.time_since_epoch()).count();
+}
+
+double SimThread::Now() {
+    return Stamp(Clock::now());
+}
+
+void SimThread::Main() {
+    Clock::time_point nextTick = Clock::now() + tickInterval_;
+    // Snapshots are stamped with the time their last tick was due rather
+    // than when it ran, so a late wake-up does not jolt the blend.
+    Clock::time_point tickTime = Clock::now();
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeLock_);
+            if (paused_) {
+                wake_.wait(lock, [&] { return stopping_ || !paused_ || !commands_.Empty(); });
+                nextTick = Clock::now() + tickInterval_;
+            } else {
+                Clock::time_point deadline = nextTick;
+                if (settleAt_ != Clock::time_point{}) deadline = std::min(deadline, settleAt_);
+                wake_.wait_until(lock, deadline, [&] { return stopping_ || paused_ || !commands_.Empty(); });
+            }
+            if (stopping_) return;
+        }
+
+        const Clock::time_point begin = Clock::now();
+        const bool changed = ApplyCommands(begin);
+        int ticks = 0;
+        while (begin >= nextTick && ticks < kMaxCatchUpTicks) {
+            UpdateAnimationStep();
+            tickTime = nextTick;
+            nextTick += tickInterval_;
+            ++ticks;
+        }
+        if (begin >= nextTick) {
+            tickTime = begin;
+            nextTick = begin + tickInterval_;
+        }
+
+        if (changed || ticks > 0) {
+            PublishSnapshot(Stamp(tickTime));
+            snapshots_.fetch_add(1, std::memory_order_relaxed);
+            if (onPublish_) onPublish_();
+        }
+        ticks_.fetch_add(static_cast<uint64_t>(ticks), std::memory_order_relaxed);
+        busyNs_.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count()),
+                          std::memory_order_relaxed);
+    }
+}
+
+void SimThread::Report(std::FILE* out) const {
+    const double elapsed = std::max(1e-9, std::chrono::duration<double>(Clock::now() - startTime_).count());
+    const uint64_t ticks = ticks_.load(std::memory_order_relaxed);
+    std::fprintf(out,
+                 "sim: %.1f Hz %.1fs ticks=%llu (%.1f/s) snapshots=%llu commands=%llu dropped=%llu cpu=%.2f ms/s\n",
+                 1.0 / std::chrono::duration<double>(tickInterval_).count(),
+                 elapsed,
+                 static_cast<unsigned long long>(ticks),
+                 ticks / elapsed,
+                 static_cast<unsigned long long>(snapshots_.load(std::memory_order_relaxed)),
+                 static_cast<unsigned long long>(commandCount_.load(std::memory_order_relaxed)),
+                 static_cast<unsigned long long>(dropped_.load(std::memory_order_relaxed)),
+                 busyNs_.load(std::memory_order_relaxed) * 1.0e-6 / elapsed);
+    std::fflush(out);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// Input from the window thread to the simulation.
+struct SimCommand {
+    enum class Type : uint8_t {
+        Resize,     // live resize; coalesced and applied with ResizeScene
+        Regenerate, // R, or the first size
+        Save,       // S; writes the scene to `path` with SaveScene
+    };
+    Type type = Type::Resize;
+    int width = 0;
+    int height = 0;
+    const char* path = nullptr; // must outlive the command
+};
+
+// Runs the scene simulation on its own thread so a slow swap or driver
+// stall never delays a tick, and a heavy tick never delays a frame. The
+// thread owns g_state: it applies commands, steps UpdateAnimationStep at
+// the tick rate and hands each result to the renderer with
+// PublishSnapshot. Commands come in through a wait-free ring, so GLFW
+// callbacks never block on the simulation.
+//
+// Live resizes are coalesced: every wake-up applies at most the latest
+// pending size with ResizeScene, and the scene is regenerated from scratch
+// once no resize has arrived for kResizeSettleSeconds.
+class SimThread {
+public:
+    static constexpr double kResizeSettleSeconds = 0.25;
+
+    ~SimThread() { Stop(); }
+
+    // `onPublish` runs on the simulation thread after every snapshot, e.g.
+    // to wake the render loop; it must be thread-safe.
+    void Start(double tickInterval, void (*onPublish)());
+    void Stop();
+    bool Running() const { return thread_.joinable(); }
+
+    // While paused the thread sleeps and simulated time stands still, the
+    // same as the animation freezing while the overlay cannot be seen.
+    void SetPaused(bool paused);
+
+    // Window thread only. Never blocks; returns false (and counts the drop)
+    // if the ring is full.
+    bool Post(const SimCommand& command);
+
+    // One "sim:" line: tick rate, ticks, snapshots, commands and the
+    // simulation's CPU time per second of wall time.
+    void Report(std::FILE* out) const;
+
+    // The clock snapshots are stamped with (SceneSnapshot::time), in
+    // seconds.
+    static double Now();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Main();
+    bool ApplyCommands(Clock::time_point now);
+
+    SpscQueue<SimCommand, 64> commands_;
+    std::thread thread_;
+    std::mutex wakeLock_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    bool paused_ = false;
+
+    Clock::duration tickInterval_{};
+    void (*onPublish_)() = nullptr;
+
+    // Simulation thread only.
+    int resizeWidth_ = 0;
+    int resizeHeight_ = 0;
+    Clock::time_point settleAt_{}; // epoch when no regeneration is due
+
+    Clock::time_point startTime_{};
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> snapshots_{0};
+    std::atomic<uint64_t> commandCount_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> busyNs_{0};
+};
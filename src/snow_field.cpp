@@ -0,0 +1,215 @@
+#include "snow_field.h"
+
+#include "rng.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define XMASS_SNOW_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(XMASS_SNOW_X86) && (defined(__GNUC__) || defined(__clang__))
+#define XMASS_TARGET(arch) __attribute__((target(arch)))
+#else
+#define XMASS_TARGET(arch)
+#endif
+
+void SnowField::Clear() {
+    x.clear();
+    y.clear();
+    speed.clear();
+    drift.clear();
+    radius.clear();
+}
+
+void SnowField::Resize(size_t n) {
+    x.resize(n);
+    y.resize(n);
+    speed.resize(n);
+    drift.resize(n);
+    radius.resize(n);
+}
+
+using SnowKernel = size_t (*)(const float*, const float*, const float*, const float*, float*, float*, size_t, size_t, float, float, float, uint32_t*);
+
+static size_t StepScalar(const float* x, const float* y, const float* speed, const float* drift, float* outX, float* outY, size_t begin, size_t end, float width, float height, float step, uint32_t* out) {
+    const float left = -10.0f;
+    const float right = width + 10.0f;
+    const float bottom = height + 10.0f;
+    size_t count = 0;
+    for (size_t i = begin; i < end; ++i) {
+        float ny = y[i] + speed[i] * step;
+        float nx = x[i] + drift[i] * step;
+        nx = nx < left ? width + 5.0f : nx;
+        nx = nx > right ? -5.0f : nx;
+        outX[i] = nx;
+        outY[i] = ny;
+        out[count] = static_cast<uint32_t>(i);
+        count += ny > bottom ? 1 : 0;
+    }
+    return count;
+}
+
+#ifdef XMASS_SNOW_X86
+XMASS_TARGET("sse2")
+static size_t StepSse2(const float* x, const float* y, const float* speed, const float* drift, float* outX, float* outY, size_t begin, size_t end, float width, float height, float step, uint32_t* out) {
+    const __m128 left = _mm_set1_ps(-10.0f);
+    const __m128 right = _mm_set1_ps(width + 10.0f);
+    const __m128 bottom = _mm_set1_ps(height + 10.0f);
+    const __m128 wrapToRight = _mm_set1_ps(width + 5.0f);
+    const __m128 wrapToLeft = _mm_set1_ps(-5.0f);
+    const __m128 scale = _mm_set1_ps(step);
+
+    size_t count = 0;
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 ny = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(speed + i), scale));
+        __m128 nx = _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(drift + i), scale));
+        __m128 m = _mm_cmplt_ps(nx, left);
+        nx = _mm_or_ps(_mm_and_ps(m, wrapToRight), _mm_andnot_ps(m, nx));
+        m = _mm_cmpgt_ps(nx, right);
+        nx = _mm_or_ps(_mm_and_ps(m, wrapToLeft), _mm_andnot_ps(m, nx));
+        _mm_storeu_ps(outX + i, nx);
+        _mm_storeu_ps(outY + i, ny);
+
+        int fell = _mm_movemask_ps(_mm_cmpgt_ps(ny, bottom));
+        while (fell) {
+            int lane = 0;
+            while (!(fell & (1 << lane))) ++lane;
+            out[count++] = static_cast<uint32_t>(i + lane);
+            fell &= fell - 1;
+        }
+    }
+    return count + StepScalar(x, y, speed, drift, outX, outY, i, end, width, height, step, out + count);
+}
+
+XMASS_TARGET("avx2")
+static size_t StepAvx2(const float* x, const float* y, const float* speed, const float* drift, float* outX, float* outY, size_t begin, size_t end, float width, float height, float step, uint32_t* out) {
+    const __m256 left = _mm256_set1_ps(-10.0f);
+    const __m256 right = _mm256_set1_ps(width + 10.0f);
+    const __m256 bottom = _mm256_set1_ps(height + 10.0f);
+    const __m256 wrapToRight = _mm256_set1_ps(width + 5.0f);
+    const __m256 wrapToLeft = _mm256_set1_ps(-5.0f);
+    const __m256 scale = _mm256_set1_ps(step);
+
+    size_t count = 0;
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 ny = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(speed + i), scale));
+        __m256 nx = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(drift + i), scale));
+        nx = _mm256_blendv_ps(nx, wrapToRight, _mm256_cmp_ps(nx, left, _CMP_LT_OQ));
+        nx = _mm256_blendv_ps(nx, wrapToLeft, _mm256_cmp_ps(nx, right, _CMP_GT_OQ));
+        _mm256_storeu_ps(outX + i, nx);
+        _mm256_storeu_ps(outY + i, ny);
+
+        int fell = _mm256_movemask_ps(_mm256_cmp_ps(ny, bottom, _CMP_GT_OQ));
+        while (fell) {
+            int lane = 0;
+            while (!(fell & (1 << lane))) ++lane;
+            out[count++] = static_cast<uint32_t>(i + lane);
+            fell &= fell - 1;
+        }
+    }
+    return count + StepScalar(x, y, speed, drift, outX, outY, i, end, width, height, step, out + count);
+}
+
+static bool CpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+struct SnowDispatch {
+    SnowKernel kernel = StepScalar;
+    const char* name = "scalar";
+};
+
+static SnowDispatch SelectKernel() {
+    SnowDispatch d;
+#ifdef XMASS_SNOW_X86
+    d.kernel = StepSse2;
+    d.name = "sse2";
+    if (CpuHasAvx2()) {
+        d.kernel = StepAvx2;
+        d.name = "avx2";
+    }
+#endif
+    return d;
+}
+
+static const SnowDispatch& Dispatch() {
+    static const SnowDispatch d = SelectKernel();
+    return d;
+}
+
+size_t StepSnowRange(const SnowField& snow, const float* x, const float* y, float* outX, float* outY,
+                     size_t begin, size_t end, float width, float height, float step, uint32_t* respawnOut) {
+    return Dispatch().kernel(x, y, snow.speed.data(), snow.drift.data(), outX, outY, begin, end, width, height, step, respawnOut);
+}
+
+void StepSnow(SnowField& snow, const float* x, const float* y, float* outX, float* outY,
+              float width, float height, float step) {
+    const size_t n = snow.Size();
+    snow.respawn.resize(n);
+    size_t count = n ? StepSnowRange(snow, x, y, outX, outY, 0, n, width, height, step, snow.respawn.data()) : 0;
+    snow.respawn.resize(count);
+}
+
+void RespawnFlake(SnowField& snow, float* x, float* y, uint32_t i, float width, Rng& rng) {
+    y[i] = rng.Float(-30.0f, -5.0f);
+    x[i] = rng.Float(0.0f, width);
+    snow.speed[i] = rng.Float(0.5f, 1.8f);
+    snow.drift[i] = rng.Float(-0.3f, 0.3f);
+    snow.radius[i] = static_cast<float>(rng.Int(1, 3));
+}
+
+void StepSnowParallel(SnowField& snow, const float* x, const float* y, float* outX, float* outY,
+                      float width, float height, float step, ThreadPool& pool, uint64_t seed) {
+    const size_t n = snow.Size();
+    const size_t blocks = (n + kSnowChunk - 1) / kSnowChunk;
+    snow.respawn.resize(n);
+    snow.blockRespawns.resize(blocks);
+    pool.ParallelFor(n, kSnowChunk, [&](size_t begin, size_t end, int) {
+        for (size_t b = begin; b < end; b += kSnowChunk) {
+            size_t e = std::min(end, b + kSnowChunk);
+            Rng rng(seed ^ (b / kSnowChunk));
+            // Each block lists its respawns in its own stretch of
+            // snow.respawn; they are packed together below.
+            uint32_t* fell = snow.respawn.data() + b;
+            size_t count = StepSnowRange(snow, x, y, outX, outY, b, e, width, height, step, fell);
+            for (size_t k = 0; k < count; ++k) {
+                RespawnFlake(snow, outX, outY, fell[k], width, rng);
+            }
+            snow.blockRespawns[b / kSnowChunk] = static_cast<uint32_t>(count);
+        }
+    });
+
+    size_t count = 0;
+    for (size_t c = 0; c < blocks; ++c) {
+        const auto first = snow.respawn.begin() + static_cast<std::ptrdiff_t>(c * kSnowChunk);
+        std::copy(first, first + snow.blockRespawns[c], snow.respawn.begin() + static_cast<std::ptrdiff_t>(count));
+        count += snow.blockRespawns[c];
+    }
+    snow.respawn.resize(count);
+}
+
+const char* SnowKernelName() {
+    return Dispatch().name;
+}
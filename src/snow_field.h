@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Rng;
+class ThreadPool;
+
+// Snowflakes stored as parallel arrays so the per-tick update runs as a
+// straight SIMD loop over x/y/speed/drift.
+struct SnowField {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> speed;
+    std::vector<float> drift;
+    std::vector<float> radius;
+
+    // Scratch for StepSnow and StepSnowParallel: indices of flakes that
+    // fell out this tick, and StepSnowParallel's count per block.
+    std::vector<uint32_t> respawn;
+    std::vector<uint32_t> blockRespawns;
+
+    size_t Size() const { return x.size(); }
+    void Clear();
+    void Resize(size_t n);
+};
+
+// Integrates one tick of `step` 30 Hz steps for flakes [begin, end):
+// y += speed * step, x += drift * step, horizontal wrap at -10 / width +
+// 10. Positions are read from `x`/`y` and written to `outX`/`outY`,
+// which may be the same arrays or live outside the field (the scene keeps
+// them in its snapshots); `snow` supplies speed and drift. Indices of
+// flakes that fell below height + 10 are appended to `respawnOut` (which
+// must have room for end - begin entries); returns how many were written.
+// The caller re-seeds those in a separate pass. Branch-free apart from the
+// respawn compaction.
+size_t StepSnowRange(const SnowField& snow, const float* x, const float* y, float* outX, float* outY,
+                     size_t begin, size_t end, float width, float height, float step, uint32_t* respawnOut);
+
+// Runs StepSnowRange over the whole field; the respawn list is left in
+// snow.respawn.
+void StepSnow(SnowField& snow, const float* x, const float* y, float* outX, float* outY,
+              float width, float height, float step);
+
+// Flakes per work item in StepSnowParallel. Each one touches 24 bytes of
+// positions, speed and drift, so a chunk stays within a typical 256 KiB L2.
+constexpr size_t kSnowChunk = 8192;
+
+// Puts flake `i` back at a random spot just above the top edge, written
+// to `x`/`y`, with a new speed, drift and size in `snow`.
+void RespawnFlake(SnowField& snow, float* x, float* y, uint32_t i, float width, Rng& rng);
+
+// Steps and respawns the field in kSnowChunk blocks spread over `pool`.
+// Block c re-seeds its flakes from Rng(seed ^ c), so the result depends on
+// `seed` alone, not on which worker ran which block. The respawned flakes
+// are left in snow.respawn, as StepSnow leaves them.
+void StepSnowParallel(SnowField& snow, const float* x, const float* y, float* outX, float* outY,
+                      float width, float height, float step, ThreadPool& pool, uint64_t seed);
+
+// "avx2", "sse2" or "scalar": the kernel picked at startup for this CPU.
+const char* SnowKernelName();
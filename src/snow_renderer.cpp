@@ -0,0 +1,172 @@
+#include "snow_renderer.h"
+
+#include "tessellation.h"
+
+#include <cstdint>
+#include <vector>
+
+static const char* kSnowVertexShader = R"(#version 330 core
+uniform vec2 uViewport;
+uniform vec4 uSmall;
+uniform vec4 uLarge;
+uniform float uStepBack;
+uniform float uPad;
+in vec2 aUnit;
+in float aX;
+in float aY;
+in float aSpeed;
+in float aDrift;
+in float aRadius;
+out vec4 vColor;
+out vec2 vLocal;
+flat out float vRadius;
+void main() {
+    vLocal = aUnit * (aRadius + uPad);
+    vRadius = aRadius;
+    vec2 p = vec2(aX - aDrift * uStepBack, aY - aSpeed * uStepBack) + vLocal;
+    vec2 ndc = p / uViewport * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    vColor = aRadius >= 3.0 ? uLarge : uSmall;
+}
+)";
+
+static const char* kSnowFragmentShader = R"(#version 330 core
+in vec4 vColor;
+out vec4 fragColor;
+void main() {
+    fragColor = vColor;
+}
+)";
+
+// SDF mode: the mesh is a quad one pixel larger than the flake and the
+// edge coverage is computed here instead of by multisampling.
+static const char* kSnowSdfFragmentShader = R"(#version 330 core
+in vec4 vColor;
+in vec2 vLocal;
+flat in float vRadius;
+out vec4 fragColor;
+void main() {
+    float coverage = clamp(vRadius + 0.5 - length(vLocal), 0.0, 1.0);
+    if (coverage <= 0.0) discard;
+    fragColor = vec4(vColor.rgb, vColor.a * coverage);
+}
+)";
+
+bool SnowRenderer::Init(bool sdf) {
+    const char* attributes[] = {"aUnit", "aX", "aY", "aSpeed", "aDrift", "aRadius"};
+    program_ = BuildProgram(kSnowVertexShader, sdf ? kSnowSdfFragmentShader : kSnowFragmentShader, attributes, 6);
+    if (!program_) {
+        return false;
+    }
+    viewportLoc_ = g_gl.GetUniformLocation(program_, "uViewport");
+    smallLoc_ = g_gl.GetUniformLocation(program_, "uSmall");
+    largeLoc_ = g_gl.GetUniformLocation(program_, "uLarge");
+    stepBackLoc_ = g_gl.GetUniformLocation(program_, "uStepBack");
+    g_gl.UseProgram(program_);
+    g_gl.Uniform1f(g_gl.GetUniformLocation(program_, "uPad"), sdf ? 1.0f : 0.0f);
+    g_gl.UseProgram(0);
+
+    // Flakes are at most 3 px, so the level for that radius is enough.
+    const CircleLod& lod = CircleLodForRadius(3.0f);
+    std::vector<float> mesh;
+    if (sdf) {
+        mesh = {-1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f};
+    } else {
+        mesh.reserve(static_cast<size_t>(lod.segments) * 2 + 4);
+        mesh.push_back(0.0f);
+        mesh.push_back(0.0f);
+        mesh.insert(mesh.end(), lod.xy, lod.xy + lod.segments * 2);
+        mesh.push_back(lod.xy[0]);
+        mesh.push_back(lod.xy[1]);
+    }
+    meshVertexCount_ = static_cast<GLsizei>(mesh.size() / 2);
+
+    g_gl.GenVertexArrays(1, &vao_);
+    g_gl.GenBuffers(1, &meshVbo_);
+    g_gl.GenBuffers(1, &flakeVbo_);
+    g_gl.GenBuffers(1, &positionVbo_);
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, meshVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(mesh.size() * sizeof(float)), mesh.data(), GL_STATIC_DRAW);
+    g_gl.EnableVertexAttribArray(0);
+    g_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void SnowRenderer::Destroy() {
+    if (positionVbo_) g_gl.DeleteBuffers(1, &positionVbo_);
+    if (flakeVbo_) g_gl.DeleteBuffers(1, &flakeVbo_);
+    if (meshVbo_) g_gl.DeleteBuffers(1, &meshVbo_);
+    if (vao_) g_gl.DeleteVertexArrays(1, &vao_);
+    if (program_) g_gl.DeleteProgram(program_);
+    positionVbo_ = 0;
+    flakeVbo_ = 0;
+    meshVbo_ = 0;
+    vao_ = 0;
+    program_ = 0;
+    boundCount_ = 0;
+}
+
+void SnowRenderer::Upload(const float* speed, const float* drift, const float* radius, size_t n) {
+    if (!program_) {
+        return;
+    }
+    // Laid out [speed... | drift... | radius...].
+    const std::ptrdiff_t slice = static_cast<std::ptrdiff_t>(n * sizeof(float));
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, flakeVbo_);
+    g_gl.BufferData(GL_ARRAY_BUFFER, slice * 3, nullptr, GL_DYNAMIC_DRAW);
+    if (n > 0) {
+        g_gl.BufferSubData(GL_ARRAY_BUFFER, 0, slice, speed);
+        g_gl.BufferSubData(GL_ARRAY_BUFFER, slice, slice, drift);
+        g_gl.BufferSubData(GL_ARRAY_BUFFER, slice * 2, slice, radius);
+    }
+    for (GLuint attr = 3; attr <= 5; ++attr) {
+        g_gl.EnableVertexAttribArray(attr);
+        g_gl.VertexAttribPointer(attr, 1, GL_FLOAT, GL_FALSE, sizeof(float), reinterpret_cast<const void*>(static_cast<uintptr_t>(slice * (attr - 3))));
+        g_gl.VertexAttribDivisor(attr, 1);
+    }
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SnowRenderer::Draw(const float* x, const float* y, size_t n, float stepBack, const Color& small, const Color& large) {
+    if (n == 0 || !program_) {
+        return;
+    }
+
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    g_gl.UseProgram(program_);
+    g_gl.Uniform2f(viewportLoc_, static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    g_gl.Uniform4f(smallLoc_, small.r, small.g, small.b, small.a);
+    g_gl.Uniform4f(largeLoc_, large.r, large.g, large.b, large.a);
+    g_gl.Uniform1f(stepBackLoc_, stepBack);
+    g_gl.BindVertexArray(vao_);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, positionVbo_);
+
+    // Laid out [x... | y...]. Reallocating it with BufferData each frame
+    // orphans the previous contents, so the upload never waits on the draw
+    // that is still reading them.
+    const std::ptrdiff_t slice = static_cast<std::ptrdiff_t>(n * sizeof(float));
+    g_gl.BufferData(GL_ARRAY_BUFFER, slice * 2, nullptr, GL_STREAM_DRAW);
+    g_gl.BufferSubData(GL_ARRAY_BUFFER, 0, slice, x);
+    g_gl.BufferSubData(GL_ARRAY_BUFFER, slice, slice, y);
+    if (boundCount_ != n) {
+        for (GLuint attr = 1; attr <= 2; ++attr) {
+            g_gl.EnableVertexAttribArray(attr);
+            g_gl.VertexAttribPointer(attr, 1, GL_FLOAT, GL_FALSE, sizeof(float), reinterpret_cast<const void*>(static_cast<uintptr_t>(slice * (attr - 1))));
+            g_gl.VertexAttribDivisor(attr, 1);
+        }
+        boundCount_ = n;
+    }
+
+    g_gl.DrawArraysInstanced(GL_TRIANGLE_FAN, 0, meshVertexCount_, static_cast<GLsizei>(n));
+    g_gl.BindVertexArray(0);
+    g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    g_gl.UseProgram(0);
+}
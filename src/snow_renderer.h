@@ -0,0 +1,44 @@
+#pragma once
+
+#include "color.h"
+#include "gl_ext.h"
+
+#include <cstddef>
+
+// Core-profile only. Draws snow straight from parallel arrays: the
+// per-flake speed, drift and radius go into one buffer when they change
+// (Upload; respawns re-roll them), and each frame only the x/y positions
+// are streamed into another. Every array gets its own slice and is bound
+// as a per-instance attribute, so nothing is repacked on the CPU no matter
+// how many flakes there are. Flakes of radius 3 and up take `large`, the
+// rest take `small`.
+//
+// Draw's `stepBack` moves each flake back along its velocity by that many
+// 30 Hz steps, which is how interpolated frames show the state between
+// two ticks.
+//
+// Init(true) draws each flake as a quad with analytic edge coverage
+// instead of a fan, for --aa=sdf.
+class SnowRenderer {
+public:
+    bool Init(bool sdf);
+    void Destroy();
+    bool Ready() const { return program_ != 0; }
+
+    void Upload(const float* speed, const float* drift, const float* radius, size_t n);
+    // `n` must match the last Upload.
+    void Draw(const float* x, const float* y, size_t n, float stepBack, const Color& small, const Color& large);
+
+private:
+    GLuint program_ = 0;
+    GLint viewportLoc_ = -1;
+    GLint smallLoc_ = -1;
+    GLint largeLoc_ = -1;
+    GLint stepBackLoc_ = -1;
+    GLuint vao_ = 0;
+    GLuint meshVbo_ = 0;
+    GLuint flakeVbo_ = 0;
+    GLuint positionVbo_ = 0;
+    size_t boundCount_ = 0;
+    GLsizei meshVertexCount_ = 0;
+};
@@ -0,0 +1,320 @@
+#include "soft_rasterizer.h"
+
+#include "batch_renderer.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XMASS_SOFT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Four-lane float vector: one RGBA pixel, or four coverage samples.
+#ifdef XMASS_SOFT_SSE2
+struct V4 {
+    __m128 v;
+};
+static inline V4 Set1(float s) { return {_mm_set1_ps(s)}; }
+static inline V4 Set(float a, float b, float c, float d) { return {_mm_setr_ps(a, b, c, d)}; }
+static inline V4 Load(const float* p) { return {_mm_loadu_ps(p)}; }
+static inline void Store(float* p, V4 a) { _mm_storeu_ps(p, a.v); }
+static inline V4 operator+(V4 a, V4 b) { return {_mm_add_ps(a.v, b.v)}; }
+static inline V4 operator-(V4 a, V4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+static inline V4 operator*(V4 a, V4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+static inline V4 Min(V4 a, V4 b) { return {_mm_min_ps(a.v, b.v)}; }
+static inline V4 Max(V4 a, V4 b) { return {_mm_max_ps(a.v, b.v)}; }
+static inline V4 Sqrt(V4 a) { return {_mm_sqrt_ps(a.v)}; }
+static inline V4 SplatW(V4 a) { return {_mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 3, 3, 3))}; }
+
+// Lanes where the edge value is inside: > 0, or == 0 on an edge that owns
+// its boundary (so shared edges are filled exactly once).
+static inline int InsideMask(V4 e, bool inclusive) {
+    __m128 zero = _mm_setzero_ps();
+    return _mm_movemask_ps(inclusive ? _mm_cmpge_ps(e.v, zero) : _mm_cmpgt_ps(e.v, zero));
+}
+#else
+struct V4 {
+    float v[4];
+};
+static inline V4 Set1(float s) { return {{s, s, s, s}}; }
+static inline V4 Set(float a, float b, float c, float d) { return {{a, b, c, d}}; }
+static inline V4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+static inline void Store(float* p, V4 a) {
+    for (int i = 0; i < 4; ++i) p[i] = a.v[i];
+}
+static inline V4 operator+(V4 a, V4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+static inline V4 operator-(V4 a, V4 b) { return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+static inline V4 operator*(V4 a, V4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+static inline V4 Min(V4 a, V4 b) {
+    return {{std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]), std::min(a.v[2], b.v[2]), std::min(a.v[3], b.v[3])}};
+}
+static inline V4 Max(V4 a, V4 b) {
+    return {{std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3])}};
+}
+static inline V4 Sqrt(V4 a) { return {{std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3])}}; }
+static inline V4 SplatW(V4 a) { return Set1(a.v[3]); }
+static inline int InsideMask(V4 e, bool inclusive) {
+    int m = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (inclusive ? e.v[i] >= 0.0f : e.v[i] > 0.0f) m |= 1 << i;
+    }
+    return m;
+}
+#endif
+
+static const int kCoverageCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+// 4x rotated-grid sample positions inside a pixel, the same pattern
+// common 4x MSAA implementations use.
+static const float kSampleX[4] = {0.375f, 0.875f, 0.125f, 0.625f};
+static const float kSampleY[4] = {0.125f, 0.375f, 0.625f, 0.875f};
+
+static inline void BlendOver(float* dst, V4 src) {
+    V4 d = Load(dst);
+    Store(dst, src + d * (Set1(1.0f) - SplatW(src)));
+}
+
+static void SetColor(float out[4], const BatchVertex& v, bool premultiplied) {
+    const float inv = 1.0f / 255.0f;
+    float a = v.a * inv;
+    float k = premultiplied ? inv : a * inv;
+    out[0] = v.r * k;
+    out[1] = v.g * k;
+    out[2] = v.b * k;
+    out[3] = a;
+}
+
+void SoftRasterizer::Resize(int width, int height) {
+    width = std::max(1, width);
+    height = std::max(1, height);
+    if (width == width_ && height == height_) return;
+    width_ = width;
+    height_ = height;
+    tilesX_ = (width + kTileSize - 1) / kTileSize;
+    tilesY_ = (height + kTileSize - 1) / kTileSize;
+    bins_.assign(static_cast<size_t>(tilesX_) * tilesY_, {});
+    pixels_.assign(static_cast<size_t>(width) * height, 0);
+}
+
+void SoftRasterizer::Begin(const uint32_t* background) {
+    background_ = background;
+    prims_.clear();
+    for (auto& bin : bins_) {
+        bin.clear();
+    }
+}
+
+void SoftRasterizer::Bin(float minX, float minY, float maxX, float maxY) {
+    if (maxX < 0.0f || maxY < 0.0f || minX >= width_ || minY >= height_) return;
+    int tx0 = std::max(0, static_cast<int>(minX) / kTileSize);
+    int ty0 = std::max(0, static_cast<int>(minY) / kTileSize);
+    int tx1 = std::min(tilesX_ - 1, static_cast<int>(maxX) / kTileSize);
+    int ty1 = std::min(tilesY_ - 1, static_cast<int>(maxY) / kTileSize);
+    const uint32_t index = static_cast<uint32_t>(prims_.size() - 1);
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            bins_[static_cast<size_t>(ty * tilesX_ + tx)].push_back(index);
+        }
+    }
+}
+
+void SoftRasterizer::Triangle(const BatchVertex& a, const BatchVertex& b, const BatchVertex& c, bool premultiplied) {
+    Primitive p;
+    p.kind = Kind::Triangle;
+    const BatchVertex* v[3] = {&a, &b, &c};
+    for (int i = 0; i < 3; ++i) {
+        p.x[i] = v[i]->x;
+        p.y[i] = v[i]->y;
+        SetColor(p.color[i], *v[i], premultiplied);
+    }
+    if (p.color[0][3] <= 0.0f && p.color[1][3] <= 0.0f && p.color[2][3] <= 0.0f) return;
+    prims_.push_back(p);
+    Bin(std::min({a.x, b.x, c.x}), std::min({a.y, b.y, c.y}), std::max({a.x, b.x, c.x}), std::max({a.y, b.y, c.y}));
+}
+
+void SoftRasterizer::Line(const BatchVertex& a, const BatchVertex& b, float width, bool premultiplied) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float len = std::sqrt(dx * dx + dy * dy);
+    if (len <= 0.0f) return;
+    float nx = -dy / len * width * 0.5f;
+    float ny = dx / len * width * 0.5f;
+
+    BatchVertex a0 = a, a1 = a, b0 = b, b1 = b;
+    a0.x += nx;
+    a0.y += ny;
+    a1.x -= nx;
+    a1.y -= ny;
+    b0.x += nx;
+    b0.y += ny;
+    b1.x -= nx;
+    b1.y -= ny;
+    Triangle(a0, b0, b1, premultiplied);
+    Triangle(a0, b1, a1, premultiplied);
+}
+
+void SoftRasterizer::Circle(float cx, float cy, float radius, const Color& c) {
+    if (radius <= 0.0f || c.a <= 0.0f) return;
+    Primitive p;
+    p.kind = Kind::Circle;
+    p.x[0] = cx;
+    p.y[0] = cy;
+    p.x[1] = radius;
+    p.color[0][0] = c.r * c.a;
+    p.color[0][1] = c.g * c.a;
+    p.color[0][2] = c.b * c.a;
+    p.color[0][3] = c.a;
+    prims_.push_back(p);
+    float reach = radius + 1.0f;
+    Bin(cx - reach, cy - reach, cx + reach, cy + reach);
+}
+
+static void RasterTriangle(const float* px, const float* py, const float (*color)[4], float* buffer, int x0, int y0, int x1, int y1) {
+    float area = (px[1] - px[0]) * (py[2] - py[0]) - (py[1] - py[0]) * (px[2] - px[0]);
+    if (area == 0.0f) return;
+    const float sign = area > 0.0f ? 1.0f : -1.0f;
+    area *= sign;
+
+    // Edge k is opposite vertex k: E_k(x, y) = A x + B y + C, positive
+    // inside and equal to twice the area at vertex k.
+    float A[3], B[3], C[3];
+    bool inclusive[3];
+    V4 offset[3];
+    for (int k = 0; k < 3; ++k) {
+        int i = (k + 1) % 3;
+        int j = (k + 2) % 3;
+        A[k] = -(py[j] - py[i]) * sign;
+        B[k] = (px[j] - px[i]) * sign;
+        C[k] = -(A[k] * px[i] + B[k] * py[i]);
+        inclusive[k] = A[k] > 0.0f || (A[k] == 0.0f && B[k] > 0.0f);
+        offset[k] = Set(A[k] * kSampleX[0] + B[k] * kSampleY[0], A[k] * kSampleX[1] + B[k] * kSampleY[1],
+                        A[k] * kSampleX[2] + B[k] * kSampleY[2], A[k] * kSampleX[3] + B[k] * kSampleY[3]);
+    }
+
+    // Color is a plane over the barycentrics: c(x, y) = base + dx * x + dy * y.
+    V4 dcdx = Set1(0.0f), dcdy = Set1(0.0f), base = Set1(0.0f);
+    const V4 invArea = Set1(1.0f / area);
+    for (int k = 0; k < 3; ++k) {
+        V4 c = Load(color[k]) * invArea;
+        dcdx = dcdx + c * Set1(A[k]);
+        dcdy = dcdy + c * Set1(B[k]);
+        base = base + c * Set1(C[k]);
+    }
+    const V4 zero = Set1(0.0f);
+    const V4 one = Set1(1.0f);
+
+    int minX = std::max(x0, static_cast<int>(std::floor(std::min({px[0], px[1], px[2]}))));
+    int minY = std::max(y0, static_cast<int>(std::floor(std::min({py[0], py[1], py[2]}))));
+    int maxX = std::min(x1, static_cast<int>(std::ceil(std::max({px[0], px[1], px[2]}))));
+    int maxY = std::min(y1, static_cast<int>(std::ceil(std::max({py[0], py[1], py[2]}))));
+
+    for (int y = minY; y < maxY; ++y) {
+        float e[3];
+        for (int k = 0; k < 3; ++k) {
+            e[k] = A[k] * minX + B[k] * y + C[k];
+        }
+        float* row = buffer + ((y - y0) * SoftRasterizer::kTileSize + (minX - x0)) * 4;
+        for (int x = minX; x < maxX; ++x, row += 4) {
+            int mask = InsideMask(Set1(e[0]) + offset[0], inclusive[0]) & InsideMask(Set1(e[1]) + offset[1], inclusive[1]) &
+                       InsideMask(Set1(e[2]) + offset[2], inclusive[2]);
+            e[0] += A[0];
+            e[1] += A[1];
+            e[2] += A[2];
+            if (!mask) continue;
+
+            V4 c = base + dcdx * Set1(x + 0.5f) + dcdy * Set1(y + 0.5f);
+            c = Min(Max(c, zero), one);
+            BlendOver(row, c * Set1(kCoverageCount[mask] * 0.25f));
+        }
+    }
+}
+
+static void RasterCircle(float cx, float cy, float radius, const float* color, float* buffer, int x0, int y0, int x1, int y1) {
+    int minX = std::max(x0, static_cast<int>(std::floor(cx - radius - 1.0f)));
+    int minY = std::max(y0, static_cast<int>(std::floor(cy - radius - 1.0f)));
+    int maxX = std::min(x1, static_cast<int>(std::ceil(cx + radius + 1.0f)));
+    int maxY = std::min(y1, static_cast<int>(std::ceil(cy + radius + 1.0f)));
+
+    // Coverage is the signed distance from the rim, clamped to one pixel.
+    const V4 src = Load(color);
+    const V4 edge = Set1(radius + 0.5f);
+    const V4 zero = Set1(0.0f);
+    const V4 one = Set1(1.0f);
+    const V4 lanes = Set(0.5f, 1.5f, 2.5f, 3.5f);
+    float coverage[4];
+    for (int y = minY; y < maxY; ++y) {
+        float dy = y + 0.5f - cy;
+        V4 dy2 = Set1(dy * dy);
+        float* row = buffer + ((y - y0) * SoftRasterizer::kTileSize + (minX - x0)) * 4;
+        for (int x = minX; x < maxX; x += 4, row += 16) {
+            V4 dx = Set1(x - cx) + lanes;
+            V4 cov = Min(Max(edge - Sqrt(dx * dx + dy2), zero), one);
+            Store(coverage, cov);
+            int n = std::min(4, maxX - x);
+            for (int i = 0; i < n; ++i) {
+                if (coverage[i] > 0.0f) {
+                    BlendOver(row + i * 4, src * Set1(coverage[i]));
+                }
+            }
+        }
+    }
+}
+
+void SoftRasterizer::RasterTile(int tile, float* buffer) {
+    const int x0 = (tile % tilesX_) * kTileSize;
+    const int y0 = (tile / tilesX_) * kTileSize;
+    const int x1 = std::min(x0 + kTileSize, width_);
+    const int y1 = std::min(y0 + kTileSize, height_);
+    const float inv = 1.0f / 255.0f;
+
+    for (int y = y0; y < y1; ++y) {
+        float* dst = buffer + (y - y0) * kTileSize * 4;
+        if (!background_) {
+            std::fill(dst, dst + (x1 - x0) * 4, 0.0f);
+            continue;
+        }
+        const uint32_t* src = background_ + static_cast<size_t>(y) * width_ + x0;
+        for (int x = 0; x < x1 - x0; ++x) {
+            uint32_t p = src[x];
+            dst[x * 4 + 0] = (p & 0xFF) * inv;
+            dst[x * 4 + 1] = ((p >> 8) & 0xFF) * inv;
+            dst[x * 4 + 2] = ((p >> 16) & 0xFF) * inv;
+            dst[x * 4 + 3] = (p >> 24) * inv;
+        }
+    }
+
+    for (uint32_t index : bins_[static_cast<size_t>(tile)]) {
+        const Primitive& p = prims_[index];
+        if (p.kind == Kind::Triangle) {
+            RasterTriangle(p.x, p.y, p.color, buffer, x0, y0, x1, y1);
+        } else {
+            RasterCircle(p.x[0], p.y[0], p.x[1], p.color[0], buffer, x0, y0, x1, y1);
+        }
+    }
+
+    const int redShift = bgra_ ? 16 : 0;
+    const int blueShift = bgra_ ? 0 : 16;
+    for (int y = y0; y < y1; ++y) {
+        const float* src = buffer + (y - y0) * kTileSize * 4;
+        uint32_t* dst = pixels_.data() + static_cast<size_t>(y) * width_ + x0;
+        for (int x = 0; x < x1 - x0; ++x) {
+            auto byte = [&](int c) { return static_cast<uint32_t>(std::min(1.0f, std::max(0.0f, src[x * 4 + c])) * 255.0f + 0.5f); };
+            dst[x] = (byte(0) << redShift) | (byte(1) << 8) | (byte(2) << blueShift) | (byte(3) << 24);
+        }
+    }
+}
+
+void SoftRasterizer::Render(ThreadPool& pool) {
+    const size_t tileFloats = static_cast<size_t>(kTileSize) * kTileSize * 4;
+    scratch_.resize(static_cast<size_t>(pool.WorkerCount()));
+    for (auto& buffer : scratch_) {
+        buffer.resize(tileFloats);
+    }
+    pool.ParallelFor(bins_.size(), 1, [&](size_t begin, size_t end, int worker) {
+        for (size_t tile = begin; tile < end; ++tile) {
+            RasterTile(static_cast<int>(tile), scratch_[static_cast<size_t>(worker)].data());
+        }
+    });
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "color.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+struct BatchVertex;
+
+// CPU rasterizer for the scene primitives, behind --gl=software. Primitives
+// are recorded in painter's order and binned into 64x64 tiles as they
+// arrive. Render then rasterizes the tiles in parallel, each into a
+// per-worker float tile buffer:
+// - Triangles (and lines, expanded to quads) use SIMD edge functions at
+//   four rotated-grid samples per pixel, for MSAA-like coverage.
+// - Circles get analytic distance coverage.
+// Everything is blended "over" in premultiplied alpha, and the finished
+// tiles are written to one premultiplied RGBA8 buffer.
+class SoftRasterizer {
+public:
+    static constexpr int kTileSize = 64;
+
+    void Resize(int width, int height);
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+
+    // Drops recorded primitives. The next Render starts from `background`
+    // (a premultiplied RGBA8 image of the same size, e.g. another
+    // rasterizer's Pixels() with RGBA output) or from transparent black.
+    void Begin(const uint32_t* background);
+
+    // Vertex colors are straight alpha unless `premultiplied` is set.
+    void Triangle(const BatchVertex& a, const BatchVertex& b, const BatchVertex& c, bool premultiplied);
+    void Line(const BatchVertex& a, const BatchVertex& b, float width, bool premultiplied);
+    void Circle(float cx, float cy, float radius, const Color& c);
+
+    // BGRA output matches 32-bit X11 TrueColor visuals on little-endian
+    // hosts; RGBA (the default) matches GL readback and --dump files.
+    void SetBgraOutput(bool bgra) { bgra_ = bgra; }
+
+    void Render(ThreadPool& pool);
+    const uint32_t* Pixels() const { return pixels_.data(); }
+    size_t PrimitiveCount() const { return prims_.size(); }
+
+private:
+    enum class Kind : uint8_t { Triangle, Circle };
+
+    // Triangles use all three vertices. Circles keep the center in
+    // x[0]/y[0], the radius in x[1] and their color in color[0].
+    struct Primitive {
+        Kind kind = Kind::Triangle;
+        float x[3] = {};
+        float y[3] = {};
+        float color[3][4] = {};
+    };
+
+    void Bin(float minX, float minY, float maxX, float maxY);
+    void RasterTile(int tile, float* buffer);
+
+    std::vector<Primitive> prims_;
+    std::vector<std::vector<uint32_t>> bins_;
+    std::vector<std::vector<float>> scratch_;
+    std::vector<uint32_t> pixels_;
+    const uint32_t* background_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+    bool bgra_ = false;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+// Unit-circle and star outlines evaluated at compile time, so drawing a
+// circle or star is a scale and translate of a table instead of a sin/cos
+// per vertex.
+
+constexpr double kTessPi = 3.14159265358979323846;
+
+// Taylor series after reducing to [-pi, pi]; accurate to well below float
+// precision, which is all the tables need.
+constexpr double ConstSin(double x) {
+    while (x > kTessPi) x -= 2.0 * kTessPi;
+    while (x < -kTessPi) x += 2.0 * kTessPi;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 14; ++n) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ConstCos(double x) {
+    return ConstSin(x + kTessPi / 2.0);
+}
+
+// Points i = 0..N-1 at angle i / N * 2pi, interleaved as x, y.
+template <int N>
+struct UnitCircleTable {
+    static constexpr int kSegments = N;
+    std::array<float, 2 * N> xy{};
+};
+
+template <int N>
+constexpr UnitCircleTable<N> MakeUnitCircleTable() {
+    UnitCircleTable<N> t{};
+    for (int i = 0; i < N; ++i) {
+        double a = static_cast<double>(i) / N * 2.0 * kTessPi;
+        t.xy[static_cast<size_t>(2 * i)] = static_cast<float>(ConstCos(a));
+        t.xy[static_cast<size_t>(2 * i + 1)] = static_cast<float>(ConstSin(a));
+    }
+    return t;
+}
+
+inline constexpr auto kCircle6 = MakeUnitCircleTable<6>();
+inline constexpr auto kCircle8 = MakeUnitCircleTable<8>();
+inline constexpr auto kCircle10 = MakeUnitCircleTable<10>();
+inline constexpr auto kCircle14 = MakeUnitCircleTable<14>();
+inline constexpr auto kCircle18 = MakeUnitCircleTable<18>();
+inline constexpr auto kCircle28 = MakeUnitCircleTable<28>();
+inline constexpr auto kCircle40 = MakeUnitCircleTable<40>();
+
+struct CircleLod {
+    int segments = 0;
+    const float* xy = nullptr;
+    float maxRadius = 0.0f; // largest radius this level keeps within ~1/4 px
+};
+
+// Ordered by segment count. A level is good up to the radius where the
+// chord sagitta r * (1 - cos(pi / n)) reaches a quarter pixel.
+inline constexpr std::array<CircleLod, 7> kCircleLods = {{
+    {6, kCircle6.xy.data(), 1.8f},
+    {8, kCircle8.xy.data(), 3.3f},
+    {10, kCircle10.xy.data(), 5.1f},
+    {14, kCircle14.xy.data(), 10.0f},
+    {18, kCircle18.xy.data(), 16.5f},
+    {28, kCircle28.xy.data(), 40.0f},
+    {40, kCircle40.xy.data(), 1.0e9f},
+}};
+
+inline const CircleLod& CircleLodForRadius(float radius) {
+    for (const CircleLod& lod : kCircleLods) {
+        if (radius <= lod.maxRadius) return lod;
+    }
+    return kCircleLods.back();
+}
+
+// Five-pointed star: even entries are outer tips, odd entries inner
+// corners, starting from the top tip (-90 degrees) and going clockwise in
+// the window's y-down space.
+constexpr std::array<float, 20> MakeStarTable() {
+    std::array<float, 20> t{};
+    for (int i = 0; i < 10; ++i) {
+        double a = (i * 36.0 - 90.0) * kTessPi / 180.0;
+        t[static_cast<size_t>(2 * i)] = static_cast<float>(ConstCos(a));
+        t[static_cast<size_t>(2 * i + 1)] = static_cast<float>(ConstSin(a));
+    }
+    return t;
+}
+
+inline constexpr std::array<float, 20> kStarTable = MakeStarTable();
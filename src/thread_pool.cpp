@@ -0,0 +1,115 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+void ThreadPool::Start(int workers) {
+    Stop();
+    if (workers <= 0) {
+        workers = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    workers = workers > 0 ? workers : 1;
+
+    stopping_ = false;
+    for (int i = 0; i < workers; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 1; i < workers; ++i) {
+        threads_.emplace_back(&ThreadPool::WorkerMain, this, i);
+    }
+}
+
+void ThreadPool::Stop() {
+    {
+        std::lock_guard<std::mutex> guard(wakeLock_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : threads_) {
+        t.join();
+    }
+    threads_.clear();
+    queues_.clear();
+}
+
+bool ThreadPool::TakeTask(int worker, Task& task) {
+    Queue& own = *queues_[worker];
+    {
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    const int n = WorkerCount();
+    for (int step = 1; step < n; ++step) {
+        Queue& victim = *queues_[(worker + step) % n];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::RunOne(int worker) {
+    Task task;
+    if (!TakeTask(worker, task)) {
+        return false;
+    }
+    (*task.fn)(task.begin, task.end, worker);
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> guard(wakeLock_);
+        done_.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::WorkerMain(int worker) {
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeLock_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+        }
+        while (RunOne(worker)) {
+        }
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t chunk, const ChunkFn& fn) {
+    if (count == 0) return;
+    if (chunk == 0) chunk = count;
+    if (threads_.empty() || count <= chunk) {
+        fn(0, count, 0);
+        return;
+    }
+
+    const int n = WorkerCount();
+    size_t chunks = (count + chunk - 1) / chunk;
+    pending_.store(chunks, std::memory_order_relaxed);
+    for (size_t c = 0; c < chunks; ++c) {
+        Task task;
+        task.begin = c * chunk;
+        task.end = std::min(count, task.begin + chunk);
+        task.fn = &fn;
+        Queue& q = *queues_[c % n];
+        std::lock_guard<std::mutex> guard(q.lock);
+        q.tasks.push_back(task);
+    }
+    {
+        std::lock_guard<std::mutex> guard(wakeLock_);
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    while (RunOne(0)) {
+    }
+    std::unique_lock<std::mutex> lock(wakeLock_);
+    done_.wait(lock, [&] { return pending_.load(std::memory_order_acquire) == 0; });
+}
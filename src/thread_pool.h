@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. ParallelFor cuts
+// [0, count) into chunks and deals them round-robin onto per-worker
+// queues. Each worker drains its own queue from the front; once that is
+// empty it steals from the back of the others. The calling thread takes
+// part as worker 0, so a pool of N workers starts N - 1 threads.
+class ThreadPool {
+public:
+    using ChunkFn = std::function<void(size_t begin, size_t end, int worker)>;
+
+    ~ThreadPool() { Stop(); }
+
+    // `workers` <= 0 uses std::thread::hardware_concurrency().
+    void Start(int workers);
+    void Stop();
+    int WorkerCount() const { return queues_.empty() ? 1 : static_cast<int>(queues_.size()); }
+
+    // Blocks until every chunk has run. With no threads started this
+    // runs the whole range inline as worker 0.
+    void ParallelFor(size_t count, size_t chunk, const ChunkFn& fn);
+
+private:
+    struct Task {
+        size_t begin = 0;
+        size_t end = 0;
+        const ChunkFn* fn = nullptr;
+    };
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    bool TakeTask(int worker, Task& task);
+    bool RunOne(int worker);
+    void WorkerMain(int worker);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex wakeLock_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::atomic<size_t> pending_{0};
+    unsigned long long generation_ = 0;
+    bool stopping_ = false;
+};
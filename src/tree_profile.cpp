@@ -0,0 +1,44 @@
+#include "tree_profile.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TreeProfile::Build(const std::vector<TreeLayer>& layers, float topY, float bottomY, float minHalfWidth) {
+    top = topY;
+    // One row past the bottom so the last in-tree scanline has a neighbour
+    // to interpolate towards.
+    const size_t rows = static_cast<size_t>(std::ceil(std::max(0.0f, bottomY - topY))) + 2;
+    halfWidth.assign(rows, 0.0f);
+    for (const TreeLayer& layer : layers) {
+        const float denom = std::max(1.0f, layer.y1 - layer.y0);
+        const size_t first = static_cast<size_t>(std::max(0.0f, std::ceil(layer.y0 - topY)));
+        const size_t last = std::min(rows - 1, static_cast<size_t>(std::max(0.0f, std::floor(layer.y1 - topY))));
+        for (size_t i = first; i <= last; ++i) {
+            const float y = topY + static_cast<float>(i);
+            halfWidth[i] = std::max(halfWidth[i], (y - layer.y0) / denom * layer.halfW);
+        }
+    }
+
+    // Area CDF over the spans [i, i+1) between scanlines (trapezoids, to
+    // match the interpolation in HalfWidthAt), inverted at one quantile per
+    // row. A span only counts if both ends are wide enough.
+    std::vector<double> cdf(rows + 1, 0.0);
+    for (size_t i = 0; i < rows; ++i) {
+        const float a = halfWidth[i];
+        const float b = i + 1 < rows ? halfWidth[i + 1] : 0.0f;
+        const float w = (a >= minHalfWidth && b >= minHalfWidth) ? 0.5f * (a + b) : 0.0f;
+        cdf[i + 1] = cdf[i] + w;
+    }
+    quantile.assign(rows, topY);
+    const double total = cdf[rows];
+    if (total <= 0.0) return;
+
+    size_t row = 0;
+    for (size_t k = 0; k < rows; ++k) {
+        const double target = total * static_cast<double>(k) / static_cast<double>(rows - 1);
+        while (row + 1 < rows && cdf[row + 1] < target) ++row;
+        const double area = cdf[row + 1] - cdf[row];
+        const double t = area > 0.0 ? std::min(1.0, (target - cdf[row]) / area) : 0.0;
+        quantile[k] = topY + static_cast<float>(static_cast<double>(row) + t);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct TreeLayer {
+    float y0 = 0.0f;
+    float y1 = 0.0f;
+    float halfW = 0.0f;
+};
+
+// The tree's silhouette sampled once per scanline when the geometry is
+// rebuilt, so placement and hit tests never walk the layers:
+// - halfWidth[i] is the widest layer at y = top + i (layers are triangles
+//   growing from their apex at y0 to halfW at y1).
+// - quantile is the inverse CDF of silhouette area over y: SampleY(u) maps
+//   a uniform u in [0, 1) to a y whose density is proportional to the
+//   half-width there. With a uniform x in +-HalfWidthAt(y), that gives a
+//   uniform point inside the silhouette with no rejection.
+struct TreeProfile {
+    float top = 0.0f;
+    std::vector<float> halfWidth;
+    std::vector<float> quantile;
+
+    // Rows narrower than `minHalfWidth` get no area in the CDF, so
+    // SampleY never lands where a caller would have to reject the sample.
+    void Build(const std::vector<TreeLayer>& layers, float topY, float bottomY, float minHalfWidth);
+
+    // Linear between scanlines; 0 outside the tree.
+    float HalfWidthAt(float y) const {
+        float f = y - top;
+        if (!(f >= 0.0f)) return 0.0f;
+        size_t i = static_cast<size_t>(f);
+        if (i + 1 >= halfWidth.size()) return 0.0f;
+        float t = f - static_cast<float>(i);
+        return halfWidth[i] + (halfWidth[i + 1] - halfWidth[i]) * t;
+    }
+
+    float SampleY(float u) const {
+        if (quantile.size() < 2) return top;
+        float f = u * static_cast<float>(quantile.size() - 1);
+        size_t i = static_cast<size_t>(f);
+        if (i + 1 >= quantile.size()) return quantile.back();
+        float t = f - static_cast<float>(i);
+        return quantile[i] + (quantile[i + 1] - quantile[i]) * t;
+    }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single-writer, single-reader handoff of whole values. The writer fills
+// WriteSlot() and Publish()es it; the reader's Acquire() switches to the
+// newest published slot. Each side owns one of the three slots outright
+// between calls and the third sits in the middle, so the only shared state
+// is one atomic byte: neither side ever waits for the other, and nothing
+// is copied on handoff. Slots are recycled, so a writer that refills a
+// slot in place keeps its allocations.
+template <typename T>
+class TripleBuffer {
+public:
+    T& WriteSlot() { return slots_[back_]; }
+
+    // Writer: makes WriteSlot() the newest value. Any published value the
+    // reader never acquired is overwritten by later writes.
+    void Publish() {
+        const uint8_t previous = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+        back_ = previous & kIndexMask;
+    }
+
+    // Reader: returns true and moves ReadSlot() to the newest value if one
+    // was published since the last call.
+    bool Acquire() {
+        if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) return false;
+        const uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & kIndexMask;
+        return true;
+    }
+
+    const T& ReadSlot() const { return slots_[front_]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+
+    std::array<T, 3> slots_{};
+    uint8_t back_ = 0;
+    uint8_t front_ = 1;
+    std::atomic<uint8_t> middle_{2};
+};
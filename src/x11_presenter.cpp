@@ -0,0 +1,182 @@
+#include "x11_presenter.h"
+
+#include "gl_platform.h"
+
+#include <cstring>
+
+#if defined(XMASS_HAVE_X11)
+#define GLFW_EXPOSE_NATIVE_X11
+#include <GLFW/glfw3native.h>
+#include <X11/Xutil.h>
+#ifdef XMASS_HAVE_XSHM
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+// XShmAttach fails asynchronously, typically with BadAccess when the server
+// runs on another host; Xlib's default handler would exit the process.
+static bool g_shmAttachFailed = false;
+
+static int OnShmAttachError(Display*, XErrorEvent*) {
+    g_shmAttachFailed = true;
+    return 0;
+}
+
+struct ShmCompletionMatch {
+    int type;
+    Drawable drawable;
+};
+
+static Bool IsShmCompletion(Display*, XEvent* event, XPointer arg) {
+    const ShmCompletionMatch* match = reinterpret_cast<const ShmCompletionMatch*>(arg);
+    return event->type == match->type && reinterpret_cast<XShmCompletionEvent*>(event)->drawable == match->drawable;
+}
+#endif
+
+bool X11Presenter::Attach(GLFWwindow* window) {
+    Detach();
+    Display* display = glfwGetX11Display();
+    if (!display) return false;
+    Window xwindow = glfwGetX11Window(window);
+
+    XWindowAttributes attributes;
+    if (!XGetWindowAttributes(display, xwindow, &attributes)) return false;
+    Visual* visual = attributes.visual;
+    if (visual->red_mask == 0xFF0000 && visual->blue_mask == 0xFF) {
+        bgra_ = true;
+    } else if (visual->red_mask == 0xFF && visual->blue_mask == 0xFF0000) {
+        bgra_ = false;
+    } else {
+        return false;
+    }
+
+    display_ = display;
+    window_ = xwindow;
+    visual_ = visual;
+    depth_ = attributes.depth;
+    gc_ = XCreateGC(display, xwindow, 0, nullptr);
+#ifdef XMASS_HAVE_XSHM
+    shmAvailable_ = XShmQueryExtension(display) == True;
+    shmCompletionType_ = shmAvailable_ ? XShmGetEventBase(display) + ShmCompletion : 0;
+#endif
+    return true;
+}
+
+void X11Presenter::ReleaseImage() {
+    if (!image_) return;
+    XImage* image = static_cast<XImage*>(image_);
+#ifdef XMASS_HAVE_XSHM
+    if (shm_) {
+        XShmSegmentInfo info{};
+        info.shmid = shmId_;
+        info.shmaddr = static_cast<char*>(shmAddr_);
+        XShmDetach(static_cast<Display*>(display_), &info);
+        XSync(static_cast<Display*>(display_), False);
+        shmdt(shmAddr_);
+        shmAddr_ = nullptr;
+        shmId_ = -1;
+    }
+#endif
+    image->data = nullptr;
+    XDestroyImage(image);
+    image_ = nullptr;
+    shm_ = false;
+}
+
+void X11Presenter::Detach() {
+    ReleaseImage();
+    if (gc_) XFreeGC(static_cast<Display*>(display_), static_cast<GC>(gc_));
+    gc_ = nullptr;
+    display_ = nullptr;
+    window_ = 0;
+}
+
+void X11Presenter::Present(const uint32_t* pixels, int width, int height) {
+    if (!display_) return;
+    Display* display = static_cast<Display*>(display_);
+    Visual* visual = static_cast<Visual*>(visual_);
+
+    if (!image_ || imageWidth_ != width || imageHeight_ != height) {
+        ReleaseImage();
+        imageWidth_ = width;
+        imageHeight_ = height;
+#ifdef XMASS_HAVE_XSHM
+        if (shmAvailable_) {
+            XShmSegmentInfo info{};
+            XImage* image = XShmCreateImage(display, visual, depth_, ZPixmap, nullptr, &info, width, height);
+            if (image) {
+                info.shmid = shmget(IPC_PRIVATE, static_cast<size_t>(image->bytes_per_line) * height, IPC_CREAT | 0600);
+                info.shmaddr = info.shmid >= 0 ? static_cast<char*>(shmat(info.shmid, nullptr, 0)) : reinterpret_cast<char*>(-1);
+                if (info.shmaddr != reinterpret_cast<char*>(-1)) {
+                    info.readOnly = False;
+                    image->data = info.shmaddr;
+                    g_shmAttachFailed = false;
+                    XErrorHandler previous = XSetErrorHandler(OnShmAttachError);
+                    XShmAttach(display, &info);
+                    XSync(display, False);
+                    XSetErrorHandler(previous);
+                    // Marked for removal now; the segment lives until both
+                    // sides detach.
+                    shmctl(info.shmid, IPC_RMID, nullptr);
+                    if (!g_shmAttachFailed) {
+                        image_ = image;
+                        shmId_ = info.shmid;
+                        shmAddr_ = info.shmaddr;
+                        shm_ = true;
+                    } else {
+                        shmdt(info.shmaddr);
+                        image->data = nullptr;
+                        XDestroyImage(image);
+                        shmAvailable_ = false;
+                    }
+                } else {
+                    if (info.shmid >= 0) shmctl(info.shmid, IPC_RMID, nullptr);
+                    image->data = nullptr;
+                    XDestroyImage(image);
+                    shmAvailable_ = false;
+                }
+            }
+        }
+#endif
+        if (!image_) {
+            image_ = XCreateImage(display, visual, depth_, ZPixmap, 0, nullptr, width, height, 32, width * 4);
+        }
+    }
+
+    XImage* image = static_cast<XImage*>(image_);
+    if (!image) return;
+    GC gc = static_cast<GC>(gc_);
+#ifdef XMASS_HAVE_XSHM
+    if (shm_) {
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(image->data + y * image->bytes_per_line, pixels + static_cast<size_t>(y) * width, static_cast<size_t>(width) * 4);
+        }
+        // The server reads the segment after XShmPutImage returns, so wait
+        // for its completion event before the next frame overwrites it.
+        // Waiting here rather than before the next copy keeps glfwPollEvents
+        // from consuming the event in between.
+        XShmPutImage(display, window_, gc, image, 0, 0, 0, 0, width, height, True);
+        ShmCompletionMatch match{shmCompletionType_, window_};
+        XEvent event;
+        XIfEvent(display, &event, IsShmCompletion, reinterpret_cast<XPointer>(&match));
+        return;
+    }
+#endif
+    // The plain path points the image straight at the caller's pixels.
+    image->data = reinterpret_cast<char*>(const_cast<uint32_t*>(pixels));
+    XPutImage(display, window_, gc, image, 0, 0, 0, 0, width, height);
+    image->data = nullptr;
+    XFlush(display);
+}
+
+#else
+
+bool X11Presenter::Attach(GLFWwindow*) {
+    return false;
+}
+
+void X11Presenter::Detach() {}
+void X11Presenter::ReleaseImage() {}
+void X11Presenter::Present(const uint32_t*, int, int) {}
+
+#endif
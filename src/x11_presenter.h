@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+struct GLFWwindow;
+
+// Shows a CPU-rendered premultiplied frame in a GLFW window created
+// without a GL context. Uses MIT-SHM when the server supports it and can
+// attach the segment (a remote server cannot), plain XPutImage otherwise.
+// Linux/X11 builds only; Attach fails elsewhere.
+class X11Presenter {
+public:
+    ~X11Presenter() { Detach(); }
+
+    bool Attach(GLFWwindow* window);
+    void Detach();
+
+    // True when the window visual wants B,G,R,A byte order.
+    bool WantsBgra() const { return bgra_; }
+    bool UsesShm() const { return shm_; }
+
+    void Present(const uint32_t* pixels, int width, int height);
+
+private:
+    void ReleaseImage();
+
+    void* display_ = nullptr;
+    unsigned long window_ = 0;
+    void* gc_ = nullptr;
+    void* visual_ = nullptr;
+    int depth_ = 0;
+    void* image_ = nullptr;
+    int shmId_ = -1;
+    void* shmAddr_ = nullptr;
+    int imageWidth_ = 0;
+    int imageHeight_ = 0;
+    bool bgra_ = true;
+    bool shm_ = false;
+    bool shmAvailable_ = false;
+    int shmCompletionType_ = 0;
+};